@@ -0,0 +1,8 @@
+// the CHECK of the check programs: prints the failed condition and exits with 1
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// variadic, so commas of template arguments need no parentheses
+#define CHECK(...) do { if (!(__VA_ARGS__)) { fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #__VA_ARGS__); exit(1); } } while (0)
@@ -0,0 +1,453 @@
+// smoke checks of namedsigslot.h included alone, so a macro or helper only the other header defines can't hide a bug
+// built as C++20 when the compiler can, for the coroutine paths; returns non zero on the first failed check
+#include "namedsigslot.h"
+#include "check.h"
+
+#include <cstring>
+#include <map>
+#include <string>
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define HAVE_PMR
+#endif
+#endif
+
+namespace
+{
+	using namespace nsNamedSigslot;
+
+#ifdef NAMEDSIGSLOT_COROUTINES
+	// a coroutine nobody awaits, it frees itself when it ends
+	struct Detached
+	{
+		struct promise_type
+		{
+			Detached get_return_object() { return {}; }
+			std::suspend_never initial_suspend() { return {}; }
+			std::suspend_never final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+	};
+
+	Detached CountEmissions(Signal<void(int), std::mutex>& signal, int& resumed)
+	{
+		// not while (co_await ...): GCC 12 miscompiles a co_await in a loop condition
+		for (;;)
+		{
+			auto value = co_await signal.Next();
+			if (!value)
+				co_return;
+			++resumed;
+		}
+	}
+#endif
+
+	void CheckEmit()
+	{
+		Signal<void(int), std::mutex> signal;
+		int sum = 0;
+		auto conn = signal.Connect([&](int v) { sum += v; });
+		signal(1);
+		signal.Emit(2);
+		CHECK(3 == sum);
+		conn.reset();
+		signal(4);
+		CHECK(3 == sum);
+	}
+
+	void CheckEmitParallel()
+	{
+		ThreadPool pool(2);
+		Signal<void(int), std::mutex> signal;
+		std::atomic<int> calls{ 0 };
+		std::vector<Signal<void(int), std::mutex>::ConnectionPtr> conns;
+		for (int i = 0; i < 100; ++i)
+			conns.push_back(signal.Connect([&](int v) { calls += v; }));
+		for (int i = 0; i < 10; ++i)
+			signal.EmitParallel(pool, 1);
+		CHECK(1000 == calls.load());
+#ifdef NAMEDSIGSLOT_COROUTINES
+		int resumed = 0;
+		CountEmissions(signal, resumed);
+		for (int i = 0; i < 7; ++i)
+			signal.EmitParallel(pool, 1);
+		CHECK(7 == resumed);
+#endif
+	}
+
+	// Enable() of the container sets every saved object, the last switch of the object or of any container wins
+	void CheckContainer()
+	{
+		Signal<void(int), std::mutex> signal;
+		ObjectContainer<Connection<void(int)>, std::mutex> first, second;
+		int calls = 0;
+		auto a = signal.Connect([&](int) { ++calls; });
+		auto b = signal.Connect([&](int) { ++calls; });
+		first.Save(a);
+		first.Save(b);
+		b->Enable(false);
+		signal(0);
+		CHECK(1 == calls);
+		first.Enable(true);
+		signal(0);
+		CHECK(3 == calls);
+		second.Save(a);
+		second.Enable(false);
+		signal(0);
+		CHECK(4 == calls);
+		first.Enable(true);
+		signal(0);
+		CHECK(6 == calls);
+	}
+
+	template<template<typename> class C>
+	struct CombinerPolicy : DefaultPolicy
+	{
+		template<typename R>
+		using Combiner = C<R>;
+	};
+
+	// what each combiner makes of the results, and of no slots at all
+	void CheckCombiners()
+	{
+		Signal<int(int), std::mutex, CombinerPolicy<LastResult>> last;
+		CHECK(0 == last(1));
+		auto last_a = last.Connect([](int v) { return v; });
+		auto last_b = last.Connect([](int v) { return v * 10; });
+		CHECK(20 == last(2));
+
+		int called = 0;
+		Signal<const char*(int), std::mutex, CombinerPolicy<FirstNonNull>> first;
+		CHECK(nullptr == first(1));
+		auto first_a = first.Connect([&](int) -> const char* { ++called; return nullptr; });
+		auto first_b = first.Connect([&](int v) -> const char* { ++called; return v > 0 ? "b" : nullptr; });
+		auto first_c = first.Connect([&](int) -> const char* { ++called; return "c"; });
+		CHECK(0 == strcmp("b", first(1)));
+		CHECK(2 == called);
+		CHECK(0 == strcmp("c", first(-1)));
+		CHECK(5 == called);
+
+		called = 0;
+		Signal<bool(int), std::mutex, CombinerPolicy<AllTrue>> veto;
+		CHECK(veto(1));
+		auto veto_a = veto.Connect([&](int v) { ++called; return v != 1; });
+		auto veto_b = veto.Connect([&](int) { ++called; return true; });
+		CHECK(!veto(1));
+		CHECK(1 == called);
+		CHECK(veto(2));
+		CHECK(3 == called);
+
+		Signal<int(int), std::mutex, CombinerPolicy<Sum>> sum;
+		CHECK(0 == sum(1));
+		auto sum_a = sum.Connect([](int v) { return v; });
+		auto sum_b = sum.Connect([](int v) { return v * 2; });
+		CHECK(9 == sum(3));
+
+		Signal<int(int), std::mutex, CombinerPolicy<Max>> max;
+		CHECK(0 == max(1));
+		auto max_a = max.Connect([](int v) { return -v; });
+		CHECK(-5 == max(5));// the first result counts even when it is below R()
+		auto max_b = max.Connect([](int v) { return v; });
+		auto max_c = max.Connect([](int v) { return v / 2; });
+		CHECK(5 == max(5));
+
+		// the default drops the results
+		called = 0;
+		Signal<int(int), std::mutex> discard;
+		auto discard_a = discard.Connect([&](int v) { ++called; return v; });
+		static_assert(std::is_void<decltype(discard(1))>::value, "DiscardResults emissions return void");
+		discard(1);
+		CHECK(1 == called);
+	}
+
+	// a batch slot has no result, the combiner only sees the normal slots around it, whichever order they run in
+	template<template<typename> class C, typename R, typename Slot>
+	R BatchBetween(Slot slot, int value)
+	{
+		Signal<R(int), std::mutex, CombinerPolicy<C>> signal;
+		int batched = 0;
+		auto head = signal.ConnectBatch([&](const int*, size_t count) { batched += static_cast<int>(count); });
+		auto normal = signal.Connect(slot);
+		auto tail = signal.ConnectBatch([&](const int*, size_t count) { batched += static_cast<int>(count); });
+		auto result = signal(value);
+		CHECK(batched >= 1);// the tail one is not called when the combiner stops after the normal slot
+		return result;
+	}
+	void CheckBatchCombiners()
+	{
+		CHECK(BatchBetween<AllTrue, bool>([](int) { return true; }, 1));
+		CHECK(!BatchBetween<AllTrue, bool>([](int) { return false; }, 1));
+		CHECK(6 == BatchBetween<LastResult, int>([](int v) { return v * 2; }, 3));
+		CHECK(3 == BatchBetween<Sum, int>([](int v) { return v; }, 3));
+		CHECK(-3 == BatchBetween<Max, int>([](int v) { return -v; }, 3));
+		CHECK(0 == strcmp("x", BatchBetween<FirstNonNull, const char*>([](int) { return "x"; }, 3)));
+
+		// EmitBatch hands the batch slot the whole span and the others each item, results dropped
+		Signal<bool(int), std::mutex, CombinerPolicy<AllTrue>> veto;
+		int batched = 0, single = 0;
+		auto batch = veto.ConnectBatch([&](const int* items, size_t count) { for (size_t i = 0; i < count; ++i) batched += items[i]; });
+		auto normal = veto.Connect([&](int v) { single += v; return false; });
+		int items[] = { 1, 2, 3 };
+		veto.EmitBatch(items, items + 3);
+		CHECK(6 == batched);
+		CHECK(6 == single);
+		// and a batch only signal is still all true
+		normal.reset();
+		CHECK(veto(4));
+		CHECK(10 == batched);
+	}
+
+	// counts what it hands out, allocators made from one share it
+	struct Arena
+	{
+		size_t allocated = 0;
+	};
+	// no default constructor: whatever gets memory from the policy must be handed the allocator
+	template<typename T>
+	struct ArenaAlloc
+	{
+		typedef T value_type;
+		Arena* arena_;
+
+		explicit ArenaAlloc(Arena& arena) : arena_(&arena) {}
+		template<typename U>
+		ArenaAlloc(const ArenaAlloc<U>& other) : arena_(other.arena_) {}
+		T* allocate(size_t n)
+		{
+			arena_->allocated += n * sizeof(T);
+			return static_cast<T*>(::operator new(n * sizeof(T)));
+		}
+		void deallocate(T* p, size_t) { ::operator delete(p); }
+		template<typename U>
+		bool operator==(const ArenaAlloc<U>& other) const { return arena_ == other.arena_; }
+		template<typename U>
+		bool operator!=(const ArenaAlloc<U>& other) const { return arena_ != other.arena_; }
+	};
+	struct ArenaPolicy : DefaultPolicy
+	{
+		template<typename T>
+		using Allocator = ArenaAlloc<T>;
+	};
+#ifdef HAVE_PMR
+	struct PmrPolicy : DefaultPolicy
+	{
+		template<typename T>
+		using Allocator = std::pmr::polymorphic_allocator<T>;
+	};
+#endif
+
+	// the connections waiting for a signal get the memory of their list from the allocator of the hub too
+	void CheckHubAllocator()
+	{
+		Arena arena;
+		SignalHub<std::mutex, ArenaPolicy> hub{ ArenaAlloc<char>(arena) };
+		int calls = 0;
+		auto early = hub.Connect<void(int)>("arena", [&](int v) { calls += v; });
+		CHECK(0 != arena.allocated);
+		auto signal = hub.AddSignal<void(int)>("arena");
+		(*signal)(1);
+		CHECK(1 == calls);
+#ifdef HAVE_PMR
+		// a stray default constructed polymorphic_allocator would throw from the null resource
+		std::pmr::monotonic_buffer_resource buffer(std::pmr::new_delete_resource());
+		auto previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+		{
+			SignalHub<std::mutex, PmrPolicy> pmr_hub{ std::pmr::polymorphic_allocator<char>(&buffer) };
+			std::vector<SignalHub<std::mutex, PmrPolicy>::ConnectionPtr<void(int)>> waiting;
+			for (int i = 0; i < 20; ++i)
+				waiting.push_back(pmr_hub.Connect<void(int)>("a signal name too long to be stored inline", [&](int v) { calls += v; }));
+			auto pmr_signal = pmr_hub.AddSignal<void(int)>("a signal name too long to be stored inline");
+			(*pmr_signal)(1);
+		}
+		std::pmr::set_default_resource(previous);
+		CHECK(21 == calls);
+#endif
+	}
+
+	// random inserts and erases over few keys against std::map: the table keeps colliding, wrapping around its end, erasing
+	// with backward shifts and growing, each key must be found with its value exactly while it is in
+	void CheckFlatHashMap()
+	{
+		FlatHashMap<uint64_t> table;
+		std::map<uint64_t, uint64_t> expected;
+		uint64_t random = 12345;
+		for (int i = 0; i < 20000; ++i)
+		{
+			random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+			// few keys at first so it stays small and dense, then more so it grows
+			uint64_t key = (random >> 33) % (i < 10000 ? 24 : 600);
+			if ((random >> 20) & 1)
+			{
+				table[key] = key * 3;
+				expected[key] = key * 3;
+			}
+			else
+				CHECK(table.Erase(key) == (1 == expected.erase(key)));
+			if (0 == i % 97)
+			{
+				CHECK(expected.size() == table.Size());
+				for (uint64_t k = 0; k < 600; ++k)
+				{
+					auto found = table.Find(k);
+					auto it = expected.find(k);
+					CHECK((nullptr != found) == (expected.end() != it));
+					if (nullptr != found)
+						CHECK(it->second == *found);
+				}
+			}
+		}
+		size_t seen = 0;
+		for (auto&& item : table)
+		{
+			CHECK(expected[item.first] == item.second);
+			++seen;
+		}
+		CHECK(expected.size() == seen);
+		// one rehash to a bigger array keeps them all
+		table.Reserve(5000);
+		for (auto&& item : expected)
+			CHECK(nullptr != table.Find(item.first) && item.second == *table.Find(item.first));
+		table.Clear();
+		CHECK(0 == table.Size() && nullptr == table.Find(1));
+	}
+
+	// which names each pattern receives, for signals added before and after it
+	void CheckPatterns()
+	{
+		SignalHub<std::mutex> hub;
+		std::map<std::string, int> calls;
+		auto before = hub.AddSignal<void(int)>("md.eq.ibm");
+		auto exact = hub.ConnectPattern<void(int)>("md.eq.ibm", [&](int) { ++calls["exact"]; });
+		auto star = hub.ConnectPattern<void(int)>("md.*.ibm", [&](int) { ++calls["star"]; });
+		auto tail = hub.ConnectPattern<void(int)>("md.#", [&](int) { ++calls["tail"]; });
+		auto hashes = hub.ConnectPattern<void(int)>("#.#", [&](int) { ++calls["hashes"]; });
+		auto other = hub.ConnectPattern<void(std::string)>("md.#", [&](std::string) { ++calls["other"]; });
+		auto after = hub.AddSignal<void(int)>("md.fx.ibm");
+		auto shorter = hub.AddSignal<void(int)>("md");
+		auto deeper = hub.AddSignal<void(int)>("md.eq.ibm.bid");
+		auto unrelated = hub.AddSignal<void(int)>("news.eq.ibm");
+
+		(*before)(0);
+		CHECK(1 == calls["exact"] && 1 == calls["star"] && 1 == calls["tail"] && 1 == calls["hashes"]);
+		(*after)(0);
+		CHECK(1 == calls["exact"] && 2 == calls["star"] && 2 == calls["tail"] && 2 == calls["hashes"]);
+		(*shorter)(0);
+		CHECK(2 == calls["star"] && 3 == calls["tail"] && 3 == calls["hashes"]);
+		(*deeper)(0);
+		CHECK(1 == calls["exact"] && 2 == calls["star"] && 4 == calls["tail"] && 4 == calls["hashes"]);
+		(*unrelated)(0);
+		CHECK(1 == calls["exact"] && 2 == calls["star"] && 4 == calls["tail"] && 5 == calls["hashes"]);
+		// the signals of another Signature are skipped
+		CHECK(0 == calls["other"]);
+		auto text = hub.AddSignal<void(std::string)>("md.text");
+		(*text)("x");
+		CHECK(1 == calls["other"] && 4 == calls["tail"]);
+
+		// dropping the subscription disconnects it from all of them, those bound later included
+		star.reset();
+		(*before)(0);
+		(*after)(0);
+		CHECK(2 == calls["star"] && 6 == calls["tail"]);
+		auto last = hub.AddSignal<void(int)>("md.zz.ibm");
+		(*last)(0);
+		CHECK(2 == calls["star"] && 7 == calls["tail"]);
+
+		// switched through any handle, the connections of a subscription follow
+		BasicConnectionBase<AtomicAccess>& handle = *tail;
+		handle.Enable(false);
+		(*before)(0);
+		(*last)(0);
+		CHECK(7 == calls["tail"] && 10 == calls["hashes"]);
+		handle.Enable(true);
+		(*last)(0);
+		CHECK(8 == calls["tail"]);
+	}
+
+	// lookups through the frozen table, of signals gone or added since too
+	void CheckFreeze()
+	{
+		SignalHub<std::mutex> hub;
+		int sum = 0;
+		std::vector<SignalHub<std::mutex>::SignalPtr<void(int)>> signals;
+		std::vector<SignalHub<std::mutex>::ConnectionPtr<void(int)>> conns;
+		for (int i = 0; i < 40; ++i)
+		{
+			auto name = "frozen." + std::to_string(i);
+			signals.push_back(hub.AddSignal<void(int)>(name));
+			conns.push_back(hub.Connect<void(int)>(name, [&sum, i](int v) { sum += i * v; }));
+		}
+		CHECK(hub.Freeze());
+		CHECK(!hub.Freeze());
+		for (int i = 0; i < 40; ++i)
+			hub.Emit<void(int)>("frozen." + std::to_string(i), 1);
+		CHECK(780 == sum);
+		hub.Emit<void(int)>("frozen.40", 1);
+		CHECK(780 == sum);
+
+		// destroyed after the freeze: not found any more, then its name is free for a new signal the shards find
+		signals[7].reset();
+		hub.Emit<void(int)>("frozen.7", 1);
+		CHECK(780 == sum);
+		auto again = hub.AddSignal<void(int)>("frozen.7");
+		auto again_conn = hub.Connect<void(int)>("frozen.7", [&](int v) { sum += 1000 * v; });
+		hub.Emit<void(int)>("frozen.7", 1);
+		CHECK(1780 == sum);
+		auto later = hub.AddSignal<void(int)>("frozen.later");
+		auto later_conn = hub.Connect<void(int)>("frozen.later", [&](int v) { sum += v; });
+		hub.Emit<void(int)>("frozen.later", 1);
+		CHECK(1781 == sum);
+		CHECK(nullptr != hub.Resolve<void(int)>("frozen.3").Get());
+	}
+
+	// an early connection of another Signature is not bound, and letting it go later doesn't touch the next early connections
+	void CheckHubMismatch()
+	{
+		SignalHub<std::mutex> hub;
+		int calls = 0;
+		auto wrong = hub.Connect<void(int)>("mismatch", [&](int) { calls += 100; });
+		{
+			auto text = hub.AddSignal<void(std::string)>("mismatch");
+			CHECK(nullptr != text);
+			(*text)("x");
+		}
+		CHECK(0 == calls);
+		CHECK(wrong->Orphaned());
+		auto right = hub.Connect<void(int)>("mismatch", [&](int) { ++calls; });
+		wrong.reset();
+		auto signal = hub.AddSignal<void(int)>("mismatch");
+		(*signal)(1);
+		CHECK(1 == calls);
+	}
+
+	void CheckHub()
+	{
+		SignalHub<std::mutex> hub;
+		int calls = 0;
+		// connected before the signal exists, bound by AddSignal
+		auto early = hub.Connect<void(int)>("a.b", [&](int v) { calls += v; });
+		auto signal = hub.AddSignal<void(int)>("a.b");
+		auto late = hub.Connect<void(int)>("a.b", [&](int v) { calls += v; });
+		hub.Emit<void(int)>("a.b", 1);
+		(*signal)(1);
+		CHECK(4 == calls);
+	}
+}
+
+int main()
+{
+	CheckEmit();
+	CheckEmitParallel();
+	CheckContainer();
+	CheckCombiners();
+	CheckBatchCombiners();
+	CheckFlatHashMap();
+	CheckHubAllocator();
+	CheckPatterns();
+	CheckFreeze();
+	CheckHubMismatch();
+	CheckHub();
+	printf("namedsigslot_only: ok\n");
+	return 0;
+}
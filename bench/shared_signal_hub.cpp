@@ -0,0 +1,170 @@
+// checks of SharedSignalHub: producers and a consumer on threads of one process, each side mapping the segment through a hub
+// of its own as separate processes would. the rings are kept small so the producers lap the consumer
+#include "namedsigslot.h"
+#include "check.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef NAMEDSIGSLOT_SHARED_MEMORY
+#include <unistd.h>
+
+namespace
+{
+	using namespace nsNamedSigslot;
+	typedef SharedSignalHub<std::mutex> Hub;
+
+	std::string Segment(const char* name)
+	{
+		return "/sigslot_check_" + std::to_string(getpid()) + "_" + name;
+	}
+
+	// a segment without room for its signal table is not made, and not left behind either
+	void CheckCreateFailure()
+	{
+		auto segment = Segment("small");
+		Hub::Remove(segment);
+		{
+			Hub hub(segment, 128, 256);
+			CHECK(!hub.Opened());
+			CHECK(EINVAL == hub.Error());
+			CHECK(!hub.AddSignal<int>("a"));
+		}
+		// made afresh instead of waiting for the failed one to be sized
+		Hub hub(segment, 1 << 20, 16);
+		CHECK(hub.Opened());
+		CHECK(0 == hub.Error());
+		CHECK(Hub::Remove(segment));
+
+		Hub bad("/no/such/directory", 1 << 20, 16);
+		CHECK(!bad.Opened());
+		CHECK(0 != bad.Error());
+	}
+
+	// a consumer which polls after the ring went around several times gets its last capacity values and counts the rest dropped
+	void CheckLapped()
+	{
+		auto segment = Segment("lapped");
+		Hub::Remove(segment);
+		Hub producer(segment, 1 << 20, 16);
+		Hub consumer(segment);
+		CHECK(producer.Opened() && consumer.Opened());
+
+		auto emitter = producer.AddSignal<uint64_t>("lapped", 16);
+		CHECK(emitter);
+		std::vector<uint64_t> received;
+		auto conn = consumer.Connect<uint64_t>("lapped", [&](const uint64_t& v) { received.push_back(v); });
+		CHECK(nullptr != conn);
+		for (uint64_t i = 0; i < 100; ++i)
+			emitter(i);
+		CHECK(16 == consumer.Poll());
+		CHECK(84 == consumer.Dropped("lapped"));
+		for (uint64_t i = 0; i < 16; ++i)
+			CHECK(84 + i == received[i]);
+
+		// the emit by name finds the same ring
+		for (uint64_t i = 100; i < 105; ++i)
+			producer.Emit<uint64_t>("lapped", i);
+		producer.Emit<uint64_t>("unknown", 0);
+		CHECK(5 == consumer.Poll());
+		CHECK(104 == received.back());
+		CHECK(84 == consumer.Dropped("lapped"));
+		CHECK(0 == consumer.Poll());
+
+		// connected before the signal is added, it gets all of its values
+		std::vector<int> early;
+		auto early_conn = consumer.Connect<int>("early", [&](const int& v) { early.push_back(v); });
+		CHECK(0 == consumer.Poll());
+		auto late = producer.AddSignal<int>("early", 16);
+		late(1);
+		late(2);
+		CHECK(2 == consumer.Poll());
+		CHECK(2 == early.size() && 1 == early[0] && 2 == early[1]);
+		// another type for the name is refused
+		CHECK(!producer.AddSignal<double>("early"));
+		CHECK(Hub::Remove(segment));
+	}
+
+	// each value carries a checksum of itself, a value torn between two writes doesn't match it
+	struct Value
+	{
+		uint64_t producer;
+		uint64_t seq;
+		uint64_t check;
+		uint64_t spare[5];
+	};
+	uint64_t Checksum(uint64_t producer, uint64_t seq) { return (seq * 0x9E3779B97F4A7C15ULL) ^ (producer + 1); }
+
+	// producers on threads of their own emit while the consumer polls: every value arrives whole, in the order of its producer,
+	// and what arrives plus what was dropped is what was emitted
+	void CheckProducersConsumer()
+	{
+		auto segment = Segment("threads");
+		Hub::Remove(segment);
+		Hub consumer(segment, 1 << 20, 16);
+		CHECK(consumer.Opened());
+		const uint64_t producers = 3, count = 100000;
+		std::vector<uint64_t> next(producers, 0);
+		uint64_t received = 0;
+		auto conn = consumer.Connect<Value>("values", [&](const Value& v)
+		{
+			CHECK(v.producer < producers);
+			CHECK(Checksum(v.producer, v.seq) == v.check);
+			for (auto spare : v.spare)
+				CHECK(v.check == spare);
+			CHECK(v.seq >= next[v.producer]);
+			next[v.producer] = v.seq + 1;
+			++received;
+		});
+
+		std::atomic<uint64_t> done{ 0 };
+		std::vector<std::thread> threads;
+		for (uint64_t p = 0; p < producers; ++p)
+		{
+			threads.emplace_back([&, p]
+			{
+				Hub hub(segment);
+				CHECK(hub.Opened());
+				auto emitter = hub.AddSignal<Value>("values", 64);
+				CHECK(emitter);
+				for (uint64_t i = 0; i < count; ++i)
+				{
+					Value v;
+					v.producer = p;
+					v.seq = i;
+					v.check = Checksum(p, i);
+					for (auto&& spare : v.spare)
+						spare = v.check;
+					emitter(v);
+				}
+				++done;
+			});
+		}
+		while (done.load() < producers)
+			consumer.Poll();
+		for (auto&& thread : threads)
+			thread.join();
+		while (consumer.Poll() > 0)
+			;
+		CHECK(received > 0);
+		CHECK(producers * count == received + consumer.Dropped("values"));
+		CHECK(Hub::Remove(segment));
+	}
+}
+
+int main()
+{
+	CheckCreateFailure();
+	CheckLapped();
+	CheckProducersConsumer();
+	printf("shared_signal_hub: ok\n");
+	return 0;
+}
+#else
+int main()
+{
+	printf("shared_signal_hub: no POSIX shared memory, skipped\n");
+	return 0;
+}
+#endif
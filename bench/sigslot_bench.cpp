@@ -0,0 +1,465 @@
+// micro benchmarks of both sigslot versions
+// usage: sigslot_bench [filter], only the cases whose name contains filter are run
+#include "sigslot.h"
+#include "namedsigslot.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const char* filter_ = nullptr;
+
+	// keeps the compiler from dropping a value it can see is unused
+	template<typename T>
+	inline void DoNotOptimize(const T& value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		volatile T sink = value;
+		(void)sink;
+#endif
+	}
+
+	// runs f, which does ops operations, a few times and prints the best time per operation
+	template<typename F>
+	void Run(const std::string& name, size_t ops, F&& f)
+	{
+		if (filter_ && std::string::npos == name.find(filter_))
+			return;
+
+		double best = 0;
+		for (int round = 0; round < 5; ++round)
+		{
+			auto start = std::chrono::steady_clock::now();
+			f();
+			auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			if (0 == round || elapsed < best)
+				best = elapsed;
+		}
+		printf("%-64s %12.1f ns/op\n", name.c_str(), best / (ops ? ops : 1));
+	}
+
+	// ops per case, big slot counts get fewer emits
+	size_t EmitCount(size_t slots)
+	{
+		return slots >= 1000 ? 2000000 / slots + 1 : 1000000;
+	}
+
+	// Signal : a Signal<void(int), ...> of either version
+	template<typename Signal>
+	void BenchEmit(const std::string& prefix)
+	{
+		const size_t counts[] = { 0, 1, 8, 1000, 100000 };
+		for (auto slots : counts)
+		{
+			Signal signal;
+			std::vector<typename Signal::ConnectionPtr> conns;
+			for (size_t i = 0; i < slots; ++i)
+				conns.push_back(signal.Connect([](int v) { DoNotOptimize(v); }));
+
+			auto emits = EmitCount(slots);
+			Run(prefix + "/emit/slots:" + std::to_string(slots), emits, [&]
+			{
+				for (size_t i = 0; i < emits; ++i)
+					signal(static_cast<int>(i));
+			});
+
+			// the same with ConnectScoped, emitting checks a flag instead of locking a weak_ptr
+			conns.clear();
+			std::vector<typename Signal::ScopedConnection> scoped;
+			for (size_t i = 0; i < slots; ++i)
+				scoped.push_back(signal.ConnectScoped([](int v) { DoNotOptimize(v); }));
+			Run(prefix + "/emit_scoped/slots:" + std::to_string(slots), emits, [&]
+			{
+				for (size_t i = 0; i < emits; ++i)
+					signal(static_cast<int>(i));
+			});
+		}
+	}
+
+	template<typename Signal>
+	void BenchChurn(const std::string& prefix)
+	{
+		const size_t ops = 200000;
+		Signal signal;
+		Run(prefix + "/connect+reset", ops, [&]
+		{
+			for (size_t i = 0; i < ops; ++i)
+			{
+				auto conn = signal.Connect([](int v) { DoNotOptimize(v); });
+				DoNotOptimize(conn);
+			}
+		});
+
+		// disconnects in the middle of a populated signal
+		std::vector<typename Signal::ConnectionPtr> conns;
+		for (size_t i = 0; i < 1000; ++i)
+			conns.push_back(signal.Connect([](int v) { DoNotOptimize(v); }));
+		Run(prefix + "/connect+reset/slots:1000", ops, [&]
+		{
+			for (size_t i = 0; i < ops; ++i)
+			{
+				auto&& conn = conns[i % conns.size()];
+				conn.reset();
+				conn = signal.Connect([](int v) { DoNotOptimize(v); });
+			}
+		});
+	}
+
+	template<typename Signal>
+	void BenchThreads(const std::string& prefix)
+	{
+		const size_t emits = 200000;
+		const size_t counts[] = { 1, 2, 4, 8 };
+		for (auto threads : counts)
+		{
+			Signal signal;
+			std::vector<typename Signal::ConnectionPtr> conns;
+			for (size_t i = 0; i < 8; ++i)
+				conns.push_back(signal.Connect([](int v) { DoNotOptimize(v); }));
+
+			// ns per emit over all threads, flat means emits scale
+			Run(prefix + "/emit/slots:8/threads:" + std::to_string(threads), emits * threads, [&]
+			{
+				std::vector<std::thread> workers;
+				for (size_t t = 0; t < threads; ++t)
+				{
+					workers.push_back(std::thread([&]
+					{
+						for (size_t i = 0; i < emits; ++i)
+							signal(static_cast<int>(i));
+					}));
+				}
+				for (auto&& worker : workers)
+					worker.join();
+			});
+		}
+	}
+
+	// StaticSignal<void(int), 8>, to set against sigslot/single_threaded/emit
+	void BenchStatic(const std::string& prefix)
+	{
+		const size_t counts[] = { 0, 1, 8 };
+		for (auto slots : counts)
+		{
+			nsSigslot::StaticSignal<void(int), 8> signal;
+			for (size_t i = 0; i < slots; ++i)
+				signal.Connect([](int v) { DoNotOptimize(v); });
+
+			auto emits = EmitCount(slots);
+			Run(prefix + "/emit/slots:" + std::to_string(slots), emits, [&]
+			{
+				for (size_t i = 0; i < emits; ++i)
+					signal(static_cast<int>(i));
+			});
+		}
+	}
+
+	// Signal : a Signal<void(int), ...> of either version with slots busy for about a microsecond, emitted serially and on Pool
+	template<typename Signal, typename Pool>
+	void BenchParallel(const std::string& prefix)
+	{
+		const size_t emits = 200;
+		const size_t counts[] = { 4, 64, 512 };
+		Pool pool;
+		for (auto slots : counts)
+		{
+			Signal signal;
+			std::vector<typename Signal::ConnectionPtr> conns;
+			for (size_t i = 0; i < slots; ++i)
+			{
+				conns.push_back(signal.Connect([](int v)
+				{
+					auto x = static_cast<double>(v);
+					for (int k = 0; k < 300; ++k)
+						x = x * 1.0000001 + 1;
+					DoNotOptimize(x);
+				}));
+			}
+			Run(prefix + "/emit_heavy/slots:" + std::to_string(slots), emits, [&]
+			{
+				for (size_t i = 0; i < emits; ++i)
+					signal(static_cast<int>(i));
+			});
+			Run(prefix + "/emit_parallel_heavy/slots:" + std::to_string(slots) + "/threads:" + std::to_string(pool.Size() + 1), emits, [&]
+			{
+				for (size_t i = 0; i < emits; ++i)
+					signal.EmitParallel(pool, static_cast<int>(i));
+			});
+		}
+	}
+
+	// Signal : a Signal<void(int), ...> with Policy::Metrics = TraceMetrics, the cost of tracing one emission and its slots
+	template<typename Signal, typename Tracer>
+	void BenchTrace(const std::string& prefix)
+	{
+		const size_t counts[] = { 1, 8 };
+		for (auto slots : counts)
+		{
+			Signal signal;
+			std::vector<typename Signal::ConnectionPtr> conns;
+			for (size_t i = 0; i < slots; ++i)
+				conns.push_back(signal.Connect([](int v) { DoNotOptimize(v); }));
+
+			auto emits = EmitCount(slots);
+			for (auto enable : { false, true })
+			{
+				Tracer::Enable(enable);
+				Run(prefix + (enable ? "/emit_traced/slots:" : "/emit_trace_off/slots:") + std::to_string(slots), emits, [&]
+				{
+					for (size_t i = 0; i < emits; ++i)
+						signal(static_cast<int>(i));
+				});
+			}
+			Tracer::Enable(false);
+		}
+	}
+	// emitters read the slot list in an epoch section instead of under the lock of the signal
+	struct SnapshotPolicy : nsSigslot::DefaultPolicy { typedef nsSigslot::SnapshotDispatch Dispatch; };
+	struct NamedSnapshotPolicy : nsNamedSigslot::DefaultPolicy { typedef nsNamedSigslot::SnapshotDispatch Dispatch; };
+	struct TracePolicy : nsSigslot::DefaultPolicy { typedef nsSigslot::TraceMetrics Metrics; };
+	struct NamedTracePolicy : nsNamedSigslot::DefaultPolicy { typedef nsNamedSigslot::TraceMetrics Metrics; };
+
+#ifdef NAMEDSIGSLOT_SHARED_MEMORY
+	// an emit into a shared memory ring and the Poll which delivers it, in one process
+	void BenchShared(const std::string& prefix)
+	{
+		struct Quote
+		{
+			int64_t time;
+			double price;
+			int quantity;
+		};
+		const size_t emits = 1000000;
+		const char* segment = "/sigslot_bench";
+		nsNamedSigslot::SharedSignalHub<std::mutex>::Remove(segment);
+		{
+			nsNamedSigslot::SharedSignalHub<std::mutex> hub(segment, 1 << 20, 16);
+			if (!hub.Opened())
+				return;
+			auto emitter = hub.AddSignal<Quote>("md.quote");
+			auto conn = hub.Connect<Quote>("md.quote", [](const Quote& quote) { DoNotOptimize(quote.price); });
+			Run(prefix + "/shared/emit", emits, [&]
+			{
+				for (size_t i = 0; i < emits; ++i)
+					emitter(Quote{ static_cast<int64_t>(i), 1.0, 1 });
+			});
+			hub.Poll();
+			Run(prefix + "/shared/emit+poll", emits, [&]
+			{
+				for (size_t i = 0; i < emits; ++i)
+				{
+					emitter(Quote{ static_cast<int64_t>(i), 1.0, 1 });
+					hub.Poll();
+				}
+			});
+		}
+		nsNamedSigslot::SharedSignalHub<std::mutex>::Remove(segment);
+	}
+#endif
+
+	// wiring a hub at startup: 5000 signals with 40 connections each, half connected before the signals exist
+	template<typename Mutex>
+	void BenchHubStartup(const std::string& prefix)
+	{
+		typedef nsNamedSigslot::SignalHub<Mutex> Hub;
+		const size_t signals = 5000, conns = 200000;
+		std::vector<std::string> names;
+		for (size_t i = 0; i < signals; ++i)
+			names.push_back("signal" + std::to_string(i));
+		auto slot = [](int v) { DoNotOptimize(v); };
+
+		Run(prefix + "/hub/startup:loop", conns, [&]
+		{
+			Hub hub;
+			std::vector<typename Hub::template ConnectionPtr<void(int)>> saved;
+			std::vector<typename Hub::template SignalPtr<void(int)>> added;
+			for (size_t i = 0; i < conns / 2; ++i)
+				saved.push_back(hub.template Connect<void(int)>(names[i % signals], slot));
+			for (auto&& name : names)
+				added.push_back(hub.template AddSignal<void(int)>(name));
+			for (size_t i = conns / 2; i < conns; ++i)
+				saved.push_back(hub.template Connect<void(int)>(names[i % signals], slot));
+		});
+		Run(prefix + "/hub/startup:bulk", conns, [&]
+		{
+			Hub hub;
+			std::vector<typename Hub::template ConnectRequest<void(int)>> early, late;
+			for (size_t i = 0; i < conns / 2; ++i)
+				early.emplace_back(names[i % signals], slot);
+			for (size_t i = conns / 2; i < conns; ++i)
+				late.emplace_back(names[i % signals], slot);
+			auto saved = hub.template ConnectMany<void(int)>(std::make_move_iterator(early.begin()), std::make_move_iterator(early.end()));
+			auto added = hub.template AddSignals<void(int)>(names.begin(), names.end());
+			auto more = hub.template ConnectMany<void(int)>(std::make_move_iterator(late.begin()), std::make_move_iterator(late.end()));
+		});
+	}
+
+	// Signal : a CoalescingSignal<void(int), ...> with 8 slots, flushed once every flush emits
+	template<typename Signal>
+	void BenchCoalescing(const std::string& prefix)
+	{
+		const size_t emits = 1000000;
+		const size_t flushes[] = { 1, 1000 };
+		for (auto flush : flushes)
+		{
+			Signal signal;
+			std::vector<typename Signal::ConnectionPtr> conns;
+			for (size_t i = 0; i < 8; ++i)
+				conns.push_back(signal.Connect([](int v) { DoNotOptimize(v); }));
+
+			Run(prefix + "/emit_coalesced/slots:8/flush-every:" + std::to_string(flush), emits, [&]
+			{
+				for (size_t i = 0; i < emits; ++i)
+				{
+					signal(static_cast<int>(i));
+					if (0 == (i + 1) % flush)
+						signal.Flush();
+				}
+			});
+		}
+	}
+
+	// emits from other threads to a ConnectAffine slot, run by this thread with pump, the PumpEvents() of the version
+	template<typename Signal, typename Pump>
+	void BenchAffine(const std::string& prefix, Pump pump)
+	{
+		const size_t emits = 200000;
+		const size_t counts[] = { 1, 2, 4 };
+		for (auto threads : counts)
+		{
+			Signal signal;
+			size_t received = 0;
+			auto conn = signal.ConnectAffine([&](int v) { DoNotOptimize(v); ++received; });
+
+			Run(prefix + "/emit_affine/threads:" + std::to_string(threads), emits * threads, [&]
+			{
+				received = 0;
+				std::vector<std::thread> workers;
+				for (size_t t = 0; t < threads; ++t)
+				{
+					workers.push_back(std::thread([&]
+					{
+						for (size_t i = 0; i < emits; ++i)
+							signal(static_cast<int>(i));
+					}));
+				}
+				while (received < emits * threads)
+					pump();
+				for (auto&& worker : workers)
+					worker.join();
+			});
+		}
+	}
+
+	template<typename Mutex>
+	void BenchHub(const std::string& prefix)
+	{
+		typedef nsNamedSigslot::SignalHub<Mutex> Hub;
+		const size_t emits = 1000000;
+		{
+			Hub hub;
+			std::vector<typename Hub::template SignalPtr<void(int)>> signals;
+			for (int i = 0; i < 1000; ++i)
+				signals.push_back(hub.template AddSignal<void(int)>("signal" + std::to_string(i)));
+			auto conn = hub.template Connect<void(int)>("signal500", [](int v) { DoNotOptimize(v); });
+
+			auto&& signal = *signals[500];
+			Run(prefix + "/hub/direct", emits, [&]
+			{
+				for (size_t i = 0; i < emits; ++i)
+					signal(static_cast<int>(i));
+			});
+			Run(prefix + "/hub/by-name:string", emits, [&]
+			{
+				for (size_t i = 0; i < emits; ++i)
+					hub.template Emit<void(int)>("signal500", static_cast<int>(i));
+			});
+			auto id = nsNamedSigslot::Intern("signal500");
+			Run(prefix + "/hub/by-name:SignalId", emits, [&]
+			{
+				for (size_t i = 0; i < emits; ++i)
+					hub.template Emit<void(int)>(id, static_cast<int>(i));
+			});
+			auto emitter = hub.template Resolve<void(int)>("signal500");
+			Run(prefix + "/hub/resolved", emits, [&]
+			{
+				for (size_t i = 0; i < emits; ++i)
+					emitter(static_cast<int>(i));
+			});
+			// by name again, once the lookups skip the locks
+			hub.Freeze();
+			Run(prefix + "/hub/frozen/by-name:SignalId", emits, [&]
+			{
+				for (size_t i = 0; i < emits; ++i)
+					hub.template Emit<void(int)>(id, static_cast<int>(i));
+			});
+		}
+
+		// connections made before their signal, bound by AddSignal
+		const size_t counts[] = { 1, 100, 10000 };
+		for (auto early : counts)
+		{
+			const size_t rounds = 100000 / early + 1;
+			Run(prefix + "/hub/add-signal/early-conns:" + std::to_string(early), rounds, [&]
+			{
+				for (size_t r = 0; r < rounds; ++r)
+				{
+					Hub hub;
+					std::vector<typename Hub::template ConnectionPtr<void(int)>> conns;
+					for (size_t i = 0; i < early; ++i)
+						conns.push_back(hub.template Connect<void(int)>("signal", [](int v) { DoNotOptimize(v); }));
+					auto signal = hub.template AddSignal<void(int)>("signal");
+					DoNotOptimize(signal);
+				}
+			});
+		}
+	}
+
+	template<typename Signal>
+	void BenchSignal(const std::string& prefix)
+	{
+		BenchEmit<Signal>(prefix);
+		BenchChurn<Signal>(prefix);
+		BenchThreads<Signal>(prefix);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1)
+		filter_ = argv[1];
+
+	BenchSignal<nsSigslot::Signal<void(int), std::recursive_mutex>>("sigslot/recursive_mutex");
+	BenchSignal<nsSigslot::Signal<void(int), std::mutex>>("sigslot/mutex");
+	BenchSignal<nsNamedSigslot::Signal<void(int), std::recursive_mutex>>("namedsigslot/recursive_mutex");
+	BenchSignal<nsNamedSigslot::Signal<void(int), std::mutex>>("namedsigslot/mutex");
+	// connecting copies the slot list, so only the small fan-outs of BenchThreads
+	BenchThreads<nsSigslot::Signal<void(int), std::mutex, SnapshotPolicy>>("sigslot/mutex/snapshot");
+	BenchThreads<nsNamedSigslot::Signal<void(int), std::mutex, NamedSnapshotPolicy>>("namedsigslot/mutex/snapshot");
+	// the baseline without locking, single threaded only
+	BenchEmit<nsSigslot::Signal<void(int), nsSigslot::SingleThreaded>>("sigslot/single_threaded");
+	BenchChurn<nsSigslot::Signal<void(int), nsSigslot::SingleThreaded>>("sigslot/single_threaded");
+	BenchStatic("sigslot/static");
+	BenchCoalescing<nsSigslot::CoalescingSignal<void(int), std::mutex>>("sigslot/mutex");
+	BenchCoalescing<nsNamedSigslot::CoalescingSignal<void(int), std::mutex>>("namedsigslot/mutex");
+	BenchAffine<nsSigslot::Signal<void(int), std::mutex>>("sigslot/mutex", []{ nsSigslot::PumpEvents(); });
+	BenchAffine<nsNamedSigslot::Signal<void(int), std::mutex>>("namedsigslot/mutex", []{ nsNamedSigslot::PumpEvents(); });
+	BenchParallel<nsSigslot::Signal<void(int), std::mutex>, nsSigslot::ThreadPool>("sigslot/mutex");
+	BenchParallel<nsNamedSigslot::Signal<void(int), std::mutex>, nsNamedSigslot::ThreadPool>("namedsigslot/mutex");
+	BenchTrace<nsSigslot::Signal<void(int), std::mutex, TracePolicy>, nsSigslot::Tracer>("sigslot/mutex");
+	BenchTrace<nsNamedSigslot::Signal<void(int), std::mutex, NamedTracePolicy>, nsNamedSigslot::Tracer>("namedsigslot/mutex");
+#ifdef NAMEDSIGSLOT_SHARED_MEMORY
+	BenchShared("namedsigslot/mutex");
+#endif
+	BenchHub<std::recursive_mutex>("namedsigslot/recursive_mutex");
+	BenchHub<std::mutex>("namedsigslot/mutex");
+	BenchHubStartup<std::mutex>("namedsigslot/mutex");
+	return 0;
+}
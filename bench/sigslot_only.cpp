@@ -0,0 +1,166 @@
+// checks of sigslot.h included alone, the counterpart of namedsigslot_only
+// built as C++20 when the compiler can, for the coroutine paths; returns non zero on the first failed check
+#include "sigslot.h"
+#include "check.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	using namespace nsSigslot;
+
+	void CheckEmit()
+	{
+		Signal<void(int), std::mutex> signal;
+		int sum = 0;
+		auto conn = signal.Connect([&](int v) { sum += v; });
+		signal(1);
+		signal.Emit(2);
+		CHECK(3 == sum);
+		conn.reset();
+		signal(4);
+		CHECK(3 == sum);
+	}
+
+	// a move-only payload goes through a T&& parameter: every slot sees the one object, the one moving it takes it
+	void CheckMoveOnly()
+	{
+		Signal<void(std::unique_ptr<int>&&), std::mutex> signal;
+		int seen = 0;
+		std::unique_ptr<int> taken;
+		auto look = signal.Connect([&](std::unique_ptr<int>&& p) { seen += p ? *p : 0; }, -1);
+		auto take = signal.Connect([&](std::unique_ptr<int>&& p) { taken = std::move(p); });
+		auto after = signal.Connect([&](std::unique_ptr<int>&& p) { seen += p ? *p : 100; }, 1);
+		signal(std::unique_ptr<int>(new int(7)));
+		CHECK(7 + 100 == seen);
+		CHECK(taken && 7 == *taken);
+	}
+
+	// lower groups run first, every slot of a group before any of the next, through connects and disconnects
+	void CheckGroups()
+	{
+		// the default recursive mutex, a slot connects below
+		Signal<void(int)> signal;
+		std::vector<int> order;
+		std::vector<std::pair<int, Signal<void(int)>::ConnectionPtr>> conns;
+		auto connect = [&](int group) { conns.emplace_back(group, signal.Connect([&order, group](int) { order.push_back(group); }, group)); };
+		auto check = [&]
+		{
+			order.clear();
+			signal(0);
+			CHECK(conns.size() == order.size());
+			for (size_t i = 1; i < order.size(); ++i)
+				CHECK(order[i - 1] <= order[i]);
+		};
+		for (int group : { 2, 0, 1, 0, 2, -1, 1, 0 })
+			connect(group);
+		check();
+		CHECK(-1 == order.front() && 2 == order.back());
+		// the last of group 0 and both of group 2 go, then groups get slots again, a new lowest one included
+		conns.erase(conns.begin() + 7);
+		conns.erase(conns.begin() + 4);
+		conns.erase(conns.begin());
+		check();
+		CHECK(1 == order.back());
+		for (int group : { 2, -5, 0, 1 })
+			connect(group);
+		check();
+		CHECK(-5 == order.front() && 2 == order.back());
+		// a connection made by a slot of an earlier group joins the next emission, in its place
+		auto late = signal.Connect([&](int) { order.push_back(-1); conns.emplace_back(3, signal.Connect([&order](int) { order.push_back(3); }, 3)); }, -1);
+		conns.emplace_back(-1, late);
+		order.clear();
+		signal(0);
+		CHECK(conns.size() - 1 == order.size());
+		conns.erase(conns.end() - 2);
+		late.reset();
+		check();
+		CHECK(3 == order.back());
+	}
+
+	// only the latest emission is kept, Flush delivers it once
+	void CheckCoalescing()
+	{
+		CoalescingSignal<void(int, std::string), std::mutex> signal;
+		std::vector<std::pair<int, std::string>> calls;
+		auto conn = signal.Connect([&](int v, std::string s) { calls.emplace_back(v, std::move(s)); });
+		CHECK(!signal.Flush());
+		signal(1, "a");
+		signal(2, "b");
+		signal.Emit(3, "c");
+		CHECK(calls.empty());
+		CHECK(signal.Pending());
+		CHECK(signal.Flush());
+		CHECK(1 == calls.size() && 3 == calls[0].first && "c" == calls[0].second);
+		CHECK(!signal.Pending());
+		CHECK(!signal.Flush());
+		CHECK(1 == calls.size());
+
+		std::tuple<int, std::string> batch[] = { std::make_tuple(4, "d"), std::make_tuple(5, "e") };
+		signal.EmitBatch(batch, batch + 2);
+		signal.Flush();
+		CHECK(2 == calls.size() && 5 == calls[1].first && "e" == calls[1].second);
+
+		// nothing is kept while it is disabled
+		signal.Enable(false);
+		signal(6, "f");
+		CHECK(!signal.Pending());
+		signal.Enable(true);
+		CHECK(!signal.Flush());
+		CHECK(2 == calls.size());
+	}
+
+	// a full StaticSignal hands out an invalid key, a freed slot is reused and its old key stays invalid
+	void CheckStaticSignal()
+	{
+		StaticSignal<void(int), 3> signal;
+		int calls = 0;
+		auto a = signal.Connect([&](int) { ++calls; });
+		auto b = signal.Connect([&](int) { calls += 10; });
+		auto c = signal.Connect([&](int) { calls += 100; });
+		CHECK(signal.Connected(a) && signal.Connected(b) && signal.Connected(c));
+		auto full = signal.Connect([&](int) { calls += 1000; });
+		CHECK(!signal.Connected(full));
+		CHECK(3 == signal.Size());
+		signal(0);
+		CHECK(111 == calls);
+
+		CHECK(signal.Disconnect(b));
+		CHECK(!signal.Disconnect(b));
+		auto d = signal.Connect([&](int) { calls += 1000; });
+		CHECK(signal.Connected(d) && !signal.Connected(b));
+		signal.Enable(b, false);// stale, must not touch d
+		calls = 0;
+		signal(0);
+		CHECK(1101 == calls);
+		signal.Enable(d, false);
+		calls = 0;
+		signal(0);
+		CHECK(101 == calls);
+
+		// a slot disconnecting itself, and one connected while emitting which waits for the next emission
+		StaticSignal<void(), 2> self;
+		int runs = 0;
+		StaticSignal<void(), 2>::Key key;
+		key = self.Connect([&] { ++runs; self.Disconnect(key); self.Connect([&] { runs += 10; }); });
+		self();
+		CHECK(1 == runs);
+		self();
+		CHECK(11 == runs);
+		CHECK(1 == self.Size());
+	}
+}
+
+int main()
+{
+	CheckEmit();
+	CheckMoveOnly();
+	CheckGroups();
+	CheckCoalescing();
+	CheckStaticSignal();
+	printf("sigslot_only: ok\n");
+	return 0;
+}
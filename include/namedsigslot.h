@@ -2,397 +2,4514 @@
 
 #include <memory>
 #include <functional>
-#include <list>
 #include <atomic>
 #include <mutex>
 #include <algorithm>
 #include <string>
 #include <map>
+#include <set>
+#include <cstring>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <tuple>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
+#include <unordered_map>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include <cassert>
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#include <string_view>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define NAMEDSIGSLOT_SHARED_MEMORY
+#endif
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include <coroutine>
+#include <optional>
+#define NAMEDSIGSLOT_COROUTINES
+#endif
 
 namespace nsNamedSigslot
 {
-	class ObjectBase
+	// where an object is stored by its owner, see SlotMap
+	struct SlotKey
 	{
-	protected:
-		std::atomic<bool> enable_ = true;
-		std::function<void(void*)> deleter_;// we need to clear this before releasing a weak pointer
+		uint32_t index;
+		uint32_t generation;// bumped on every Erase, so stale keys never match a reused slot
+	};
+
+	// a lock which does nothing, for objects used by a single thread
+	struct NullMutex
+	{
+		void lock() {}
+		bool try_lock() { return true; }
+		void unlock() {}
+	};
+
+	// a std::atomic look-alike for values which never leave their thread
+	template<typename T>
+	class PlainAtomic
+	{
+		T value_;
 	public:
-		virtual ~ObjectBase(){}
-		virtual void OnFinal(){deleter_ = nullptr;}
-		void Enable(bool enable = true){ enable_ = enable; }
-		bool Enabled(){ return enable_; }
+		PlainAtomic(T value = T()) : value_(value) {}
+		PlainAtomic(const PlainAtomic&) = delete;
+		PlainAtomic& operator=(const PlainAtomic&) = delete;
+		T load(std::memory_order = std::memory_order_seq_cst) const { return value_; }
+		void store(T value, std::memory_order = std::memory_order_seq_cst) { value_ = value; }
+		T fetch_add(T arg, std::memory_order = std::memory_order_seq_cst) { auto old = value_; value_ += arg; return old; }
+		T fetch_sub(T arg, std::memory_order = std::memory_order_seq_cst) { auto old = value_; value_ -= arg; return old; }
+		bool compare_exchange_strong(T& expected, T desired, std::memory_order = std::memory_order_seq_cst)
+		{
+			if (value_ != expected)
+			{
+				expected = value_;
+				return false;
+			}
+			value_ = desired;
+			return true;
+		}
+		T operator=(T value) { value_ = value; return value; }
+		operator T() const { return value_; }
 	};
 
-	class NamedObjectBase :
-		public ObjectBase
+	// the control block of a LocalPtr, the object lives inside it
+	class LocalControl
 	{
+		size_t strong_ = 0;
+		size_t weak_ = 0;
+		template<typename>
+		friend class LocalPtr;
+		template<typename>
+		friend class LocalWeakPtr;
+
+		void AddStrong() { ++strong_; }
+		void ReleaseStrong()
+		{
+			if (0 != --strong_)
+				return;
+			++weak_;// the object may drop weak references to itself while it is destroyed
+			Destroy();
+			ReleaseWeak();
+		}
+		void AddWeak() { ++weak_; }
+		void ReleaseWeak()
+		{
+			if (0 == --weak_ && 0 == strong_)
+				Free();
+		}
 	protected:
-		std::string name_;
+		virtual void Destroy() = 0;
+		virtual void Free() { delete this; }
 	public:
-		std::string Name(){ return name_; }
+		virtual ~LocalControl() {}
 	};
 
-	class ConnectionBase :
-		public NamedObjectBase
+	template<typename T>
+	class LocalBlock :
+		public LocalControl
 	{
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_;
+	public:
+		template<typename ...Args>
+		LocalBlock(Args&&... args) { new (&storage_) T(std::forward<Args>(args)...); }
+		T* Get() { return reinterpret_cast<T*>(&storage_); }
 	protected:
-		std::string sig_name_;
+		void Destroy() override { Get()->~T(); }
+	};
+
+	// a LocalBlock allocated by an allocator, made by PlainAccess::AllocateShared
+	template<typename T, typename Alloc>
+	class LocalAllocatedBlock :
+		public LocalBlock<T>
+	{
+		typedef typename std::allocator_traits<Alloc>::template rebind_alloc<LocalAllocatedBlock> BlockAlloc;
+		BlockAlloc alloc_;
 	public:
-		std::string SigName(){ return sig_name_; }
+		template<typename ...Args>
+		LocalAllocatedBlock(const Alloc& alloc, Args&&... args) : LocalBlock<T>(std::forward<Args>(args)...), alloc_(alloc) {}
+	protected:
+		void Free() override
+		{
+			BlockAlloc alloc(alloc_);
+			this->~LocalAllocatedBlock();
+			std::allocator_traits<BlockAlloc>::deallocate(alloc, this, 1);
+		}
 	};
 
-	template<typename Signature>
-	class Connection:
-		public ConnectionBase
+	// std::shared_ptr with plain reference counts, for objects which never leave their thread. made by PlainAccess::MakeShared
+	template<typename T>
+	class LocalPtr
 	{
-		template<typename Signature, typename Mutex>
-		friend class Signal;
-		template<typename Mutex>
-		friend class SignalHub;
-		std::function<Signature> slot_;
+		template<typename>
+		friend class LocalPtr;
+		template<typename>
+		friend class LocalWeakPtr;
+		friend struct PlainAccess;
+		T* ptr_ = nullptr;
+		LocalControl* control_ = nullptr;
 
-		template <typename ...Params>
-		void operator()(Params&&... params)
+		LocalPtr(T* ptr, LocalControl* control) : ptr_(ptr), control_(control)
+		{
+			if (control_)
+				control_->AddStrong();
+		}
+	public:
+		typedef T element_type;
+		LocalPtr() {}
+		LocalPtr(std::nullptr_t) {}
+		LocalPtr(const LocalPtr& other) : LocalPtr(other.ptr_, other.control_) {}
+		LocalPtr(LocalPtr&& other) : ptr_(other.ptr_), control_(other.control_)
+		{
+			other.ptr_ = nullptr;
+			other.control_ = nullptr;
+		}
+		template<typename U, typename = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+		LocalPtr(const LocalPtr<U>& other) : LocalPtr(other.ptr_, other.control_) {}
+		template<typename U, typename = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+		LocalPtr(LocalPtr<U>&& other) : ptr_(other.ptr_), control_(other.control_)
+		{
+			other.ptr_ = nullptr;
+			other.control_ = nullptr;
+		}
+		~LocalPtr() { reset(); }
+		LocalPtr& operator=(LocalPtr other)
+		{
+			swap(other);
+			return *this;
+		}
+		void swap(LocalPtr& other)
+		{
+			std::swap(ptr_, other.ptr_);
+			std::swap(control_, other.control_);
+		}
+		void reset()
+		{
+			auto control = control_;
+			ptr_ = nullptr;
+			control_ = nullptr;
+			if (control)
+				control->ReleaseStrong();
+		}
+		T* get() const { return ptr_; }
+		T& operator*() const { return *ptr_; }
+		T* operator->() const { return ptr_; }
+		explicit operator bool() const { return nullptr != ptr_; }
+		friend bool operator==(const LocalPtr& p, std::nullptr_t) { return nullptr == p.ptr_; }
+		friend bool operator==(std::nullptr_t, const LocalPtr& p) { return nullptr == p.ptr_; }
+		friend bool operator!=(const LocalPtr& p, std::nullptr_t) { return nullptr != p.ptr_; }
+		friend bool operator!=(std::nullptr_t, const LocalPtr& p) { return nullptr != p.ptr_; }
+	};
+
+	// std::weak_ptr for LocalPtr
+	template<typename T>
+	class LocalWeakPtr
+	{
+		template<typename>
+		friend class LocalWeakPtr;
+		T* ptr_ = nullptr;
+		LocalControl* control_ = nullptr;
+
+		LocalWeakPtr(T* ptr, LocalControl* control) : ptr_(ptr), control_(control)
+		{
+			if (control_)
+				control_->AddWeak();
+		}
+	public:
+		LocalWeakPtr() {}
+		LocalWeakPtr(const LocalWeakPtr& other) : LocalWeakPtr(other.ptr_, other.control_) {}
+		LocalWeakPtr(LocalWeakPtr&& other) : ptr_(other.ptr_), control_(other.control_)
+		{
+			other.ptr_ = nullptr;
+			other.control_ = nullptr;
+		}
+		template<typename U, typename = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+		LocalWeakPtr(const LocalWeakPtr<U>& other) : LocalWeakPtr(other.ptr_, other.control_) {}
+		template<typename U, typename = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+		LocalWeakPtr(const LocalPtr<U>& other) : LocalWeakPtr(other.ptr_, other.control_) {}
+		~LocalWeakPtr() { reset(); }
+		LocalWeakPtr& operator=(LocalWeakPtr other)
+		{
+			std::swap(ptr_, other.ptr_);
+			std::swap(control_, other.control_);
+			return *this;
+		}
+		void reset()
+		{
+			auto control = control_;
+			ptr_ = nullptr;
+			control_ = nullptr;
+			if (control)
+				control->ReleaseWeak();
+		}
+		bool expired() const { return nullptr == control_ || 0 == control_->strong_; }
+		LocalPtr<T> lock() const { return expired() ? LocalPtr<T>() : LocalPtr<T>(ptr_, control_); }
+	};
+
+	/*
+	tells when memory swapped out from under lock-free readers can be freed: a reader announces the epoch it starts in, a writer
+	stamps what it swapped out with the epoch it ends, and frees it once no reader still in its section announced an epoch as old.
+	the sections of a thread nest, the outermost announces; a thread takes a record on first use and gives it back when it exits
+	*/
+	class AtomicEpoch
+	{
+		struct Record
+		{
+			std::atomic<uint64_t> active{ 0 };// the epoch announced, 0 outside sections
+			std::atomic<bool> used{ true };
+			uint32_t depth = 0;// of nested sections, only touched by the thread holding the record
+			Record* next = nullptr;// records are never freed, so readers of the list need no care
+			char padding[64];// keeps the records of two threads off one cache line
+		};
+		std::atomic<uint64_t> epoch_{ 1 };
+		std::atomic<Record*> records_{ nullptr };
+
+		static AtomicEpoch& Instance()
+		{
+			static AtomicEpoch epoch;
+			return epoch;
+		}
+		// gives the record of a thread back when it exits
+		struct Holder
+		{
+			Record* record_ = nullptr;
+			~Holder()
+			{
+				if (record_)
+					record_->used.store(false, std::memory_order_release);
+			}
+		};
+		static Record& Here()
+		{
+			static thread_local Holder holder;
+			if (nullptr == holder.record_)
+				holder.record_ = Instance().Take();
+			return *holder.record_;
+		}
+		Record* Take()
+		{
+			for (auto record = records_.load(std::memory_order_acquire); record; record = record->next)
+			{
+				bool expected = false;
+				if (!record->used.load(std::memory_order_relaxed) && record->used.compare_exchange_strong(expected, true, std::memory_order_acquire))
+					return record;
+			}
+			auto record = new Record;
+			record->next = records_.load(std::memory_order_relaxed);
+			while (!records_.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed))
+				;
+			return record;
+		}
+	public:
+		// held by a reader while it uses what a writer may swap out; seq_cst, so a writer's scan of the records sees the epoch
+		// of any reader which could have loaded what it swapped out
+		class Guard
+		{
+			Record& record_;
+		public:
+			Guard() : record_(Here())
+			{
+				if (0 == record_.depth++)
+					record_.active.store(Instance().epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+			}
+			~Guard()
+			{
+				if (0 == --record_.depth)
+					record_.active.store(0, std::memory_order_release);
+			}
+			Guard(const Guard&) = delete;
+			Guard& operator=(const Guard&) = delete;
+		};
+		// the stamp of what a writer swapped out, with a seq_cst store, just before
+		static uint64_t Retire() { return Instance().epoch_.fetch_add(1, std::memory_order_seq_cst); }
+		// what was stamped before it is no longer read by anyone
+		static uint64_t Oldest()
+		{
+			auto oldest = ~uint64_t(0);
+			for (auto record = Instance().records_.load(std::memory_order_acquire); record; record = record->next)
+			{
+				auto active = record->active.load(std::memory_order_seq_cst);
+				if (0 != active && active < oldest)
+					oldest = active;
+			}
+			return oldest;
+		}
+	};
+	// the AtomicEpoch of one thread, for PlainAccess: what a writer swapped out can go when the thread is in no section
+	class LocalEpoch
+	{
+		static uint32_t& Depth()
+		{
+			static thread_local uint32_t depth = 0;
+			return depth;
+		}
+	public:
+		struct Guard
+		{
+			Guard() { ++Depth(); }
+			~Guard() { --Depth(); }
+			Guard(const Guard&) = delete;
+			Guard& operator=(const Guard&) = delete;
+		};
+		static uint64_t Retire() { return 0; }
+		static uint64_t Oldest() { return 0 == Depth() ? 1 : 0; }
+	};
+
+	// how state reachable from several objects is shared: atomically, or with plain loads, stores and counts
+	struct AtomicAccess
+	{
+		template<typename T>
+		using Atomic = std::atomic<T>;
+		template<typename T>
+		using SharedPtr = std::shared_ptr<T>;
+		template<typename T>
+		using WeakPtr = std::weak_ptr<T>;
+
+		template<typename T, typename ...Args>
+		static std::shared_ptr<T> MakeShared(Args&&... args) { return std::make_shared<T>(std::forward<Args>(args)...); }
+		template<typename T, typename Alloc, typename ...Args>
+		static std::shared_ptr<T> AllocateShared(const Alloc& alloc, Args&&... args) { return std::allocate_shared<T>(alloc, std::forward<Args>(args)...); }
+		template<typename T, typename U>
+		static std::shared_ptr<T> DynamicCast(const std::shared_ptr<U>& p) { return std::dynamic_pointer_cast<T>(p); }
+		typedef AtomicEpoch Epoch;
+	};
+	struct PlainAccess
+	{
+		template<typename T>
+		using Atomic = PlainAtomic<T>;
+		template<typename T>
+		using SharedPtr = LocalPtr<T>;
+		template<typename T>
+		using WeakPtr = LocalWeakPtr<T>;
+
+		template<typename T, typename ...Args>
+		static LocalPtr<T> MakeShared(Args&&... args)
+		{
+			auto block = new LocalBlock<T>(std::forward<Args>(args)...);
+			return LocalPtr<T>(block->Get(), block);
+		}
+		template<typename T, typename Alloc, typename ...Args>
+		static LocalPtr<T> AllocateShared(const Alloc& alloc, Args&&... args)
+		{
+			typedef LocalAllocatedBlock<T, Alloc> Block;
+			typename std::allocator_traits<Alloc>::template rebind_alloc<Block> block_alloc(alloc);
+			auto block = new (std::allocator_traits<decltype(block_alloc)>::allocate(block_alloc, 1)) Block(alloc, std::forward<Args>(args)...);
+			return LocalPtr<T>(block->Get(), block);
+		}
+		template<typename T, typename U>
+		static LocalPtr<T> DynamicCast(const LocalPtr<U>& p)
+		{
+			auto ptr = dynamic_cast<T*>(p.get());
+			return ptr ? LocalPtr<T>(ptr, p.control_) : LocalPtr<T>();
+		}
+		typedef LocalEpoch Epoch;
+	};
+
+	/*
+	threading models, given to Signal, ObjectContainer and SignalHub in place of a mutex
+	MultiThreaded : objects may be shared by threads, Mutex guards them and flags and reference counts are atomic
+	SingleThreaded : everything stays on one thread, no locking and plain counters; connections are LocalPtr instead of std::shared_ptr
+	a plain mutex type is taken as MultiThreaded<mutex>
+	*/
+	template<typename Mutex = std::recursive_mutex>
+	struct MultiThreaded :
+		AtomicAccess
+	{
+		typedef Mutex Lock;
+		typedef AtomicAccess Access;
+	};
+	struct SingleThreaded :
+		PlainAccess
+	{
+		typedef NullMutex Lock;
+		typedef PlainAccess Access;
+	};
+	template<typename T>
+	struct ThreadingOf { typedef MultiThreaded<T> type; };
+	template<typename Mutex>
+	struct ThreadingOf<MultiThreaded<Mutex>> { typedef MultiThreaded<Mutex> type; };
+	template<>
+	struct ThreadingOf<SingleThreaded> { typedef SingleThreaded type; };
+
+	template<typename Access>
+	class BasicObjectBase;
+	// keeps weak references to objects, gets told when one of them goes away
+	template<typename Access>
+	class BasicOwnerBase
+	{
+	public:
+		virtual void Detach(BasicObjectBase<Access>* p, SlotKey key) = 0;
+	protected:
+		~BasicOwnerBase(){}
+	};
+
+	/*
+	the switch an ObjectContainer turns its objects on and off with, shared by the container and the objects saved to it.
+	the last Enable() wins, of a container or of the object itself: both store a state stamped from one clock, the newest counts
+	*/
+	template<typename Access>
+	class BasicEnableGate
+	{
+		typename Access::template Atomic<uint64_t> state_{ 1 };// see Stamp, enabled before any Enable()
+		typename Access::template Atomic<size_t> refs_{ 1 };
+	public:
+		BasicEnableGate() = default;
+		BasicEnableGate(const BasicEnableGate&) = delete;
+		BasicEnableGate& operator=(const BasicEnableGate&) = delete;
+		void AddRef(){ refs_.fetch_add(1, std::memory_order_relaxed); }
+		void Release()
+		{
+			if (1 == refs_.fetch_sub(1, std::memory_order_acq_rel))
+				delete this;
+		}
+		// a state newer than all stamped before: the stamp shifted left, enable in the low bit. the clock is shared by every
+		// thread, even with SingleThreaded, since objects of different threads may be enabled at once
+		static uint64_t Stamp(bool enable)
+		{
+			static std::atomic<uint64_t> clock{ 0 };
+			return ((clock.fetch_add(1, std::memory_order_relaxed) + 1) << 1) | (enable ? 1 : 0);
+		}
+		void Enable(bool enable = true){ state_.store(Stamp(enable), std::memory_order_release); }
+		uint64_t State(){ return state_.load(std::memory_order_acquire); }
+	};
+
+	template<typename Access>
+	class BasicObjectBase
+	{
+	protected:
+		typedef BasicEnableGate<Access> Gate;
+		// the gates of the containers after the first one we were saved to, never removed before we go away
+		struct GateLink
+		{
+			Gate* gate;
+			GateLink* next;
+		};
+		typename Access::template Atomic<uint64_t> enable_{ 1 };// stamped as the state of a Gate
+		typename Access::template Atomic<bool> orphaned_{ false };// set by OnFinal
+		typename Access::template Atomic<Gate*> gate_{ nullptr };// the gate of the first container we were saved to, see Join
+		typename Access::template Atomic<GateLink*> more_gates_{ nullptr };
+		BasicOwnerBase<Access>* owner_ = nullptr;// we need to clear this before the owner goes away
+		SlotKey key_ = SlotKey{ 0xffffffff, 0 };
+		// owners look us up by name, so this is called from the destructors that still have the names around
+		void Release()
+		{
+			auto owner = owner_;
+			owner_ = nullptr;
+			if (owner)
+				owner->Detach(this, key_);
+		}
+	public:
+		virtual ~BasicObjectBase()
+		{
+			Release();
+			auto gate = gate_.load(std::memory_order_relaxed);
+			if (gate)
+				gate->Release();
+			auto link = more_gates_.load(std::memory_order_relaxed);
+			while (link)
+			{
+				auto next = link->next;
+				link->gate->Release();
+				delete link;
+				link = next;
+			}
+		}
+		virtual void OnFinal(){ owner_ = nullptr; orphaned_ = true; }
+		// virtual for the subscriptions of SignalHub::ConnectPattern, which switch their connections too
+		virtual void Enable(bool enable = true){ enable_.store(Gate::Stamp(enable), std::memory_order_release); }
+		// whichever was switched last: our Enable() or that of an ObjectContainer we were saved to
+		bool Enabled()
+		{
+			auto state = enable_.load(std::memory_order_acquire);
+			auto gate = gate_.load(std::memory_order_acquire);
+			if (nullptr == gate)
+				return 0 != (state & 1);
+			state = std::max(state, gate->State());
+			for (auto link = more_gates_.load(std::memory_order_acquire); link; link = link->next)
+				state = std::max(state, link->gate->State());
+			return 0 != (state & 1);
+		}
+		// whether our owner went away, e.g. a connection whose signal is gone: nothing will ever call it again
+		bool Orphaned(){ return orphaned_; }
+		// follow the Enable() of gate too. we keep our state until it is switched again, as its earlier Enable() is older
+		void Join(Gate* gate)
 		{
-			if (!Enabled())
+			auto state = enable_.load(std::memory_order_relaxed);
+			while (!enable_.compare_exchange_strong(state, Gate::Stamp(0 != (state & 1)), std::memory_order_acq_rel))
+				;
+			gate->AddRef();
+			Gate* expected = nullptr;
+			if (gate_.compare_exchange_strong(expected, gate, std::memory_order_acq_rel))
+				return;
+			auto joined = expected == gate;
+			for (auto link = more_gates_.load(std::memory_order_acquire); link && !joined; link = link->next)
+				joined = link->gate == gate;
+			if (joined)
+			{
+				gate->Release();
 				return;
-			slot_(params...);
+			}
+			auto link = new GateLink{ gate, more_gates_.load(std::memory_order_relaxed) };
+			while (!more_gates_.compare_exchange_strong(link->next, link, std::memory_order_acq_rel))
+				;
 		}
-		template <typename ...Params>
-		void Emit(Params&&... params)
+	};
+	typedef BasicOwnerBase<AtomicAccess> OwnerBase;
+	typedef BasicObjectBase<AtomicAccess> ObjectBase;
+	typedef BasicEnableGate<AtomicAccess> EnableGate;
+
+	// a member function bound at compile time to an object: one pointer to copy, and a call the compiler can see through.
+	// what Connect<&Class::Method>(object) stores in the Slot of the connection
+	template<typename Method, Method method, typename Class>
+	struct MemberSlot
+	{
+		Class* object_;
+		template<typename ...Args>
+		auto operator()(Args&&... args) const -> decltype((object_->*method)(std::forward<Args>(args)...))
 		{
-			operator()(params...);
+			return (object_->*method)(std::forward<Args>(args)...);
 		}
 	};
 
-	class SignalBase :
-		public NamedObjectBase
+	// what Signal::Connect<&Class::Method> looks for in Class, see Trackable
+	template<typename Access>
+	class BasicTrackableBase
 	{
+	public:
+		virtual void Track(typename Access::template SharedPtr<BasicObjectBase<Access>> conn) = 0;
+	protected:
+		~BasicTrackableBase(){}
 	};
 
-	template<typename Signature, typename Mutex = std::recursive_mutex>
-	class Signal :
-		public SignalBase
+	/*
+	derive a receiver from it and the member functions connected with signal.Connect<&Class::Method>(this) are disconnected when it
+	goes away: it keeps the connections, the signal a weak reference as usual, so emitting checks nothing more. it is destroyed
+	after the derived class, emissions on other threads must be over by then. copies start with no connection
+	*/
+	template<typename Threading = std::recursive_mutex>
+	class Trackable :
+		public BasicTrackableBase<typename ThreadingOf<Threading>::type::Access>
 	{
-		typedef std::pair<void*, std::weak_ptr<Connection<Signature>>> WeakConnection;
-		template<typename Mutex>
-		friend class SignalHub;
-		Mutex lock_;
-		std::list<WeakConnection> conns_;
-#if defined(_DEBUG) || defined(DEBUG)
-		std::map<std::string, WeakConnection> named_conns_;
-#endif
+		typedef typename ThreadingOf<Threading>::type ThreadingModel;
+		typedef typename ThreadingModel::template SharedPtr<BasicObjectBase<typename ThreadingModel::Access>> ObjectPtr;
+		typename ThreadingModel::Lock lock_;
+		std::vector<ObjectPtr> conns_;
+		size_t prune_at_ = 16;// conns_ is swept for the connections of dead signals when it reaches this size
 	public:
-		~Signal()
+		Trackable() {}
+		Trackable(const Trackable&) : Trackable() {}
+		Trackable& operator=(const Trackable&) { return *this; }
+		virtual ~Trackable() { DisconnectAll(); }
+		void Track(ObjectPtr conn) override
 		{
 			std::lock_guard<decltype(lock_)> l(lock_);
-			for (auto&& conn : conns_)
+			if (conns_.size() >= prune_at_)
+			{
+				conns_.erase(std::remove_if(conns_.begin(), conns_.end(), [](const ObjectPtr& item) { return item->Orphaned(); }), conns_.end());
+				prune_at_ = std::max<size_t>(16, conns_.size() * 2);
+			}
+			conns_.push_back(std::move(conn));
+		}
+		void DisconnectAll()
+		{
+			std::vector<ObjectPtr> conns;
+			{
+				std::lock_guard<decltype(lock_)> l(lock_);
+				conns.swap(conns_);
+			}
+			// released without our lock, they take the lock of their signal which may be calling us
+		}
+	};
+
+	// emission strategies, picked by Policy::Dispatch
+	// LockedDispatch : slots run with the signal's lock held, concurrent emitters wait for each other
+	// SnapshotDispatch : emitters read an immutable copy of the slot list in an Access::Epoch section, taking no lock and no
+	//                    reference count on the copy; each Connect() slot is still locked through its weak reference, ConnectScoped()
+	//                    slots are not. Connect and compaction pay for it by publishing a new copy
+	struct LockedDispatch {};
+	struct SnapshotDispatch {};
+
+	// a copy of the latency histogram of a slot
+	struct LatencyStats
+	{
+		uint64_t count = 0;
+		uint64_t total_ns = 0;
+		std::vector<uint64_t> buckets;// buckets[i] counts the calls which took [LatencyHistogram::LowerBound(i), LowerBound(i + 1)) ns
+		// the lower bound of the bucket holding the calls at fraction (0 to 1) of count
+		uint64_t Percentile(double fraction) const;
+	};
+	struct SlotMetrics
+	{
+		std::string name;
+		LatencyStats latency;
+	};
+	struct SignalMetrics
+	{
+		std::string name;
+		uint64_t emits = 0;
+		std::vector<SlotMetrics> slots;
+	};
+
+	/*
+	log-linear histogram of nanoseconds: each power of 2 is split into 4 buckets, so a bucket is at most 25% wide.
+	recording is one relaxed increment, values from 2^36 ns (about a minute) up share the last bucket
+	*/
+	class LatencyHistogram
+	{
+	public:
+		static const unsigned SubBits = 2;
+		static const size_t Buckets = (36 - SubBits + 1) << SubBits;
+	private:
+		std::atomic<uint64_t> buckets_[Buckets];
+		std::atomic<uint64_t> total_ns_{ 0 };
+
+		static unsigned Log2(uint64_t value)
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			return 63 - __builtin_clzll(value);
+#else
+			unsigned result = 0;
+			while (value >>= 1)
+				++result;
+			return result;
+#endif
+		}
+	public:
+		LatencyHistogram()
+		{
+			for (auto&& bucket : buckets_)
+				bucket.store(0, std::memory_order_relaxed);
+		}
+		static size_t Index(uint64_t ns)
+		{
+			if (ns < (1u << SubBits))
+				return static_cast<size_t>(ns);
+			auto exponent = Log2(ns);
+			auto index = ((exponent - SubBits + 1) << SubBits) + ((ns >> (exponent - SubBits)) & ((1u << SubBits) - 1));
+			return index < Buckets ? index : Buckets - 1;
+		}
+		static uint64_t LowerBound(size_t index)
+		{
+			if (index < (1u << SubBits))
+				return index;
+			auto exponent = (index >> SubBits) + SubBits - 1;
+			return (static_cast<uint64_t>((1u << SubBits) + (index & ((1u << SubBits) - 1)))) << (exponent - SubBits);
+		}
+		void Record(uint64_t ns)
+		{
+			buckets_[Index(ns)].fetch_add(1, std::memory_order_relaxed);
+			total_ns_.fetch_add(ns, std::memory_order_relaxed);
+		}
+		LatencyStats Read() const
+		{
+			LatencyStats result;
+			result.buckets.resize(Buckets);
+			for (size_t i = 0; i < Buckets; ++i)
+			{
+				result.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+				result.count += result.buckets[i];
+			}
+			result.total_ns = total_ns_.load(std::memory_order_relaxed);
+			return result;
+		}
+	};
+
+	inline uint64_t LatencyStats::Percentile(double fraction) const
+	{
+		auto rank = static_cast<uint64_t>(fraction * count);
+		uint64_t seen = 0;
+		for (size_t i = 0; i < buckets.size(); ++i)
+		{
+			seen += buckets[i];
+			if (seen > rank)
+				return LatencyHistogram::LowerBound(i);
+		}
+		return buckets.empty() ? 0 : LatencyHistogram::LowerBound(buckets.size() - 1);
+	}
+
+	// Policy::Metrics, keeps nothing and compiles away
+	struct NoMetrics
+	{
+		struct SignalCounters {};
+		struct ConnectionCounters {};
+		struct Tick {};
+		template<typename Signal>
+		static void Emitted(SignalCounters&, Signal&, uint64_t = 1) {}
+		static Tick Start() { return Tick(); }
+		template<typename Connection>
+		static void Invoked(ConnectionCounters&, Tick, Connection&) {}
+		static void Read(const SignalCounters&, SignalMetrics&) {}
+		static void Read(const ConnectionCounters&, SlotMetrics&) {}
+	};
+	// Policy::Metrics, counts the emits of each signal and times each slot call, read them with ReadMetrics()
+	struct CollectMetrics
+	{
+		struct SignalCounters
+		{
+			std::atomic<uint64_t> emits{ 0 };
+		};
+		typedef LatencyHistogram ConnectionCounters;
+		typedef std::chrono::steady_clock::time_point Tick;
+		template<typename Signal>
+		static void Emitted(SignalCounters& counters, Signal&, uint64_t count = 1) { counters.emits.fetch_add(count, std::memory_order_relaxed); }
+		static Tick Start() { return std::chrono::steady_clock::now(); }
+		template<typename Connection>
+		static void Invoked(ConnectionCounters& counters, Tick start, Connection&)
+		{
+			counters.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+		}
+		static void Read(const SignalCounters& counters, SignalMetrics& metrics) { metrics.emits = counters.emits.load(std::memory_order_relaxed); }
+		static void Read(const ConnectionCounters& counters, SlotMetrics& metrics) { metrics.latency = counters.Read(); }
+	};
+
+	/*
+	where TraceMetrics writes: a ring of the last Capacity records of each thread, written without a lock or a shared cache line
+	and read by Dump() while threads keep tracing. signals and slots are recorded by the id of their name, see Name().
+	times are raw ticks of Now(), the TSC where there is one; ChromeTrace() turns records into the JSON chrome://tracing
+	and Perfetto load. tracing starts disabled, Enable() is a switch every traced emission checks
+	*/
+	class Tracer
+	{
+	public:
+		enum Kind { EmitRecord, SlotRecord };
+		struct Record
+		{
+			uint64_t begin;// in ticks of Now()
+			uint64_t end;// the same as begin for emissions
+			uint64_t count;// the items of an EmitBatch, 1 otherwise
+			Kind kind;
+			uint32_t thread;// numbered from 1 in the order threads first traced
+			uint32_t signal;// a name id, 0 when unknown
+			uint32_t slot;// a name id, 0 for emissions
+		};
+		static const size_t Capacity = 4096;// records kept per thread, a power of two
+	private:
+		// written by its thread alone, each record is guarded by a sequence number odd while it is being written
+		struct Ring
+		{
+			struct Entry
+			{
+				std::atomic<uint64_t> seq{ 0 };
+				std::atomic<uint64_t> begin{ 0 };
+				std::atomic<uint64_t> end{ 0 };
+				std::atomic<uint64_t> count{ 0 };
+				std::atomic<uint64_t> ids{ 0 };// signal << 32 | slot
+				std::atomic<uint64_t> kind{ 0 };
+			};
+			std::atomic<uint64_t> head_{ 0 };// records written so far
+			uint32_t thread_;
+			Entry entries_[Capacity];
+			explicit Ring(uint32_t thread) : thread_(thread) {}
+		};
+		std::atomic<bool> enable_{ false };
+		std::mutex lock_;
+		std::vector<std::shared_ptr<Ring>> rings_;// of the threads which traced, kept after they exit until Clear()
+		uint32_t threads_ = 0;
+		std::vector<std::string> names_;// names_[id - 1]
+		std::unordered_map<std::string, uint32_t> ids_;
+		uint64_t start_ticks_;// the time the tracer was made, to scale ticks to time
+		std::chrono::steady_clock::time_point start_time_;
+
+		Tracer() : start_ticks_(Now()), start_time_(std::chrono::steady_clock::now()) {}
+		static Tracer& Instance()
+		{
+			static Tracer tracer;
+			return tracer;
+		}
+		static Ring& Here()
+		{
+			static thread_local std::shared_ptr<Ring> ring;
+			if (!ring)
+			{
+				auto&& tracer = Instance();
+				std::lock_guard<std::mutex> l(tracer.lock_);
+				ring = std::make_shared<Ring>(++tracer.threads_);
+				tracer.rings_.push_back(ring);
+			}
+			return *ring;
+		}
+		static void Escape(std::string& out, const std::string& text)
+		{
+			for (auto c : text)
+			{
+				if ('"' == c || '\\' == c)
+				{
+					out += '\\';
+					out += c;
+				}
+				else if (static_cast<unsigned char>(c) < 0x20)
+				{
+					char code[8];
+					snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+					out += code;
+				}
+				else
+					out += c;
+			}
+		}
+	public:
+		Tracer(const Tracer&) = delete;
+		Tracer& operator=(const Tracer&) = delete;
+		static void Enable(bool enable = true) { Instance().enable_.store(enable, std::memory_order_relaxed); }
+		static bool Enabled() { return Instance().enable_.load(std::memory_order_relaxed); }
+		// a cycle count where the CPU has one, nanoseconds of steady_clock otherwise
+		static uint64_t Now()
+		{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+			return __rdtsc();
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+			return __builtin_ia32_rdtsc();
+#else
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+		}
+		// the id of name, made on first use. cache : where the caller keeps it, 0 until then; name() is only called to make it
+		template<typename F>
+		static uint32_t Id(std::atomic<uint32_t>& cache, F&& name)
+		{
+			auto id = cache.load(std::memory_order_relaxed);
+			if (0 != id)
+				return id;
+			auto text = name();
+			auto&& tracer = Instance();
+			{
+				std::lock_guard<std::mutex> l(tracer.lock_);
+				auto it = tracer.ids_.find(text);
+				if (tracer.ids_.end() == it)
+				{
+					tracer.names_.push_back(text);
+					it = tracer.ids_.emplace(std::move(text), static_cast<uint32_t>(tracer.names_.size())).first;
+				}
+				id = it->second;
+			}
+			cache.store(id, std::memory_order_relaxed);
+			return id;
+		}
+		// the name of an id, empty for 0
+		static std::string Name(uint32_t id)
+		{
+			auto&& tracer = Instance();
+			std::lock_guard<std::mutex> l(tracer.lock_);
+			return 0 == id || id > tracer.names_.size() ? std::string() : tracer.names_[id - 1];
+		}
+		static void Write(Kind kind, uint32_t signal, uint32_t slot, uint64_t begin, uint64_t end, uint64_t count = 1)
+		{
+			auto&& ring = Here();
+			auto head = ring.head_.load(std::memory_order_relaxed);
+			auto&& entry = ring.entries_[head & (Capacity - 1)];
+			entry.seq.store(2 * head + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			entry.begin.store(begin, std::memory_order_relaxed);
+			entry.end.store(end, std::memory_order_relaxed);
+			entry.count.store(count, std::memory_order_relaxed);
+			entry.ids.store(static_cast<uint64_t>(signal) << 32 | slot, std::memory_order_relaxed);
+			entry.kind.store(kind, std::memory_order_relaxed);
+			entry.seq.store(2 * head + 2, std::memory_order_release);
+			ring.head_.store(head + 1, std::memory_order_release);
+		}
+		// the records of all threads which are still in their rings, by begin; those being overwritten meanwhile are left out
+		static std::vector<Record> Dump()
+		{
+			std::vector<std::shared_ptr<Ring>> rings;
+			{
+				auto&& tracer = Instance();
+				std::lock_guard<std::mutex> l(tracer.lock_);
+				rings = tracer.rings_;
+			}
+			std::vector<Record> result;
+			for (auto&& ring : rings)
+			{
+				auto head = ring->head_.load(std::memory_order_acquire);
+				for (auto i = head > Capacity ? head - Capacity : 0; i < head; ++i)
+				{
+					auto&& entry = ring->entries_[i & (Capacity - 1)];
+					if (entry.seq.load(std::memory_order_acquire) != 2 * i + 2)
+						continue;
+					Record record;
+					record.begin = entry.begin.load(std::memory_order_relaxed);
+					record.end = entry.end.load(std::memory_order_relaxed);
+					record.count = entry.count.load(std::memory_order_relaxed);
+					auto ids = entry.ids.load(std::memory_order_relaxed);
+					record.kind = static_cast<Kind>(entry.kind.load(std::memory_order_relaxed));
+					std::atomic_thread_fence(std::memory_order_acquire);
+					if (entry.seq.load(std::memory_order_relaxed) != 2 * i + 2)
+						continue;
+					record.thread = ring->thread_;
+					record.signal = static_cast<uint32_t>(ids >> 32);
+					record.slot = static_cast<uint32_t>(ids);
+					result.push_back(record);
+				}
+			}
+			std::sort(result.begin(), result.end(), [](const Record& a, const Record& b) { return a.begin < b.begin; });
+			return result;
+		}
+		// how many ticks of Now() make a microsecond, measured since the tracer was made
+		static double TicksPerMicrosecond()
+		{
+			auto&& tracer = Instance();
+			auto ticks = Now() - tracer.start_ticks_;
+			auto us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - tracer.start_time_).count();
+			return us > 0 && ticks > 0 ? ticks / us : 1000;
+		}
+		// records in the Trace Event Format: emissions are instant events, slot calls complete ones, by thread
+		static std::string ChromeTrace(const std::vector<Record>& records)
+		{
+			auto scale = TicksPerMicrosecond();
+			auto origin = records.empty() ? 0 : records.front().begin;
+			std::string result = "{\"traceEvents\":[";
+			char number[96];
+			for (size_t i = 0; i < records.size(); ++i)
+			{
+				auto&& record = records[i];
+				result += i ? ",\n{\"name\":\"" : "\n{\"name\":\"";
+				Escape(result, Name(SlotRecord == record.kind ? record.slot : record.signal));
+				if (SlotRecord == record.kind)
+				{
+					snprintf(number, sizeof(number), "\",\"cat\":\"slot\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+						record.thread, (record.begin - origin) / scale, (record.end - record.begin) / scale);
+					result += number;
+					if (record.signal)
+					{
+						result += ",\"args\":{\"signal\":\"";
+						Escape(result, Name(record.signal));
+						result += "\"}";
+					}
+					result += "}";
+				}
+				else
+				{
+					snprintf(number, sizeof(number), "\",\"cat\":\"emit\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%.3f",
+						record.thread, (record.begin - origin) / scale);
+					result += number;
+					snprintf(number, sizeof(number), ",\"args\":{\"count\":%llu}}", static_cast<unsigned long long>(record.count));
+					result += number;
+				}
+			}
+			result += "\n]}\n";
+			return result;
+		}
+		// forgets the records written so far and the rings of threads which exited, names stay
+		static void Clear()
+		{
+			auto&& tracer = Instance();
+			std::lock_guard<std::mutex> l(tracer.lock_);
+			tracer.rings_.erase(std::remove_if(tracer.rings_.begin(), tracer.rings_.end(),
+				[](const std::shared_ptr<Ring>& ring) { return 1 == ring.use_count(); }), tracer.rings_.end());
+			for (auto&& ring : tracer.rings_)
+			{
+				for (auto&& entry : ring->entries_)
+					entry.seq.store(0, std::memory_order_relaxed);
+			}
+		}
+	};
+	/*
+	Policy::Metrics, writes each emission and each slot call with its duration to the Tracer while Tracer::Enabled().
+	they are named by Name() and SigName(), by address when those are empty
+	*/
+	struct TraceMetrics
+	{
+		struct SignalCounters
+		{
+			std::atomic<uint32_t> id{ 0 };// of the name, see Tracer::Id
+		};
+		struct ConnectionCounters
+		{
+			std::atomic<uint32_t> id{ 0 };
+			std::atomic<uint32_t> signal{ 0 };
+		};
+		typedef uint64_t Tick;
+		static std::string NameOf(std::string name, const char* kind, const void* p)
+		{
+			if (!name.empty())
+				return name;
+			char text[48];
+			snprintf(text, sizeof(text), "%s@%p", kind, p);
+			return text;
+		}
+		template<typename Signal>
+		static void Emitted(SignalCounters& counters, Signal& signal, uint64_t count = 1)
+		{
+			if (!Tracer::Enabled())
+				return;
+			auto now = Tracer::Now();
+			Tracer::Write(Tracer::EmitRecord, Tracer::Id(counters.id, [&]{ return NameOf(signal.Name(), "signal", &signal); }), 0, now, now, count);
+		}
+		static Tick Start() { return Tracer::Enabled() ? Tracer::Now() : 0; }
+		template<typename Connection>
+		static void Invoked(ConnectionCounters& counters, Tick start, Connection& conn)
+		{
+			if (0 == start)
+				return;
+			auto end = Tracer::Now();
+			Tracer::Write(Tracer::SlotRecord, Tracer::Id(counters.signal, [&]{ return NameOf(conn.SigName(), "signal", nullptr); }),
+				Tracer::Id(counters.id, [&]{ return NameOf(conn.Name(), "slot", &conn); }), start, end);
+		}
+		static void Read(const SignalCounters&, SignalMetrics&) {}
+		static void Read(const ConnectionCounters&, SlotMetrics&) {}
+	};
+
+	/*
+	combiners, picked by Policy::Combiner, fold the results of the slots of one emission into what the emission returns.
+	one is made for each emission, gets the result of each slot through operator(), which returns false to stop the emission,
+	and Result() is returned. queued slots, ConnectBatch slots and EmitBatch have no say in it. write your own the same way
+	*/
+	// drops the results, the emission returns void
+	template<typename R>
+	struct DiscardResults
+	{
+		typedef void ResultType;
+		template<typename T>
+		bool operator()(T&&) { return true; }
+		void Result() {}
+	};
+	// the result of the last slot, R() without slots
+	template<typename R>
+	class LastResult
+	{
+	public:
+		typedef typename std::decay<R>::type ResultType;
+	private:
+		ResultType result_ = ResultType();
+	public:
+		template<typename T>
+		bool operator()(T&& value)
+		{
+			result_ = std::forward<T>(value);
+			return true;
+		}
+		ResultType Result() { return std::move(result_); }
+	};
+	// the first result which converts to true, the later slots are not called
+	template<typename R>
+	class FirstNonNull
+	{
+	public:
+		typedef typename std::decay<R>::type ResultType;
+	private:
+		ResultType result_ = ResultType();
+	public:
+		template<typename T>
+		bool operator()(T&& value)
+		{
+			if (!value)
+				return true;
+			result_ = std::forward<T>(value);
+			return false;
+		}
+		ResultType Result() { return std::move(result_); }
+	};
+	// a veto chain: false as soon as a slot returns false, the later slots are not called. true without slots
+	template<typename R>
+	class AllTrue
+	{
+		bool result_ = true;
+	public:
+		typedef bool ResultType;
+		template<typename T>
+		bool operator()(T&& value)
+		{
+			result_ = static_cast<bool>(value);
+			return result_;
+		}
+		bool Result() { return result_; }
+	};
+	// the sum of the results, R() without slots
+	template<typename R>
+	class Sum
+	{
+	public:
+		typedef typename std::decay<R>::type ResultType;
+	private:
+		ResultType result_ = ResultType();
+	public:
+		template<typename T>
+		bool operator()(T&& value)
+		{
+			result_ += std::forward<T>(value);
+			return true;
+		}
+		ResultType Result() { return std::move(result_); }
+	};
+	// the greatest result, R() without slots
+	template<typename R>
+	class Max
+	{
+	public:
+		typedef typename std::decay<R>::type ResultType;
+	private:
+		ResultType result_ = ResultType();
+		bool seen_ = false;
+	public:
+		template<typename T>
+		bool operator()(T&& value)
+		{
+			if (!seen_ || result_ < value)
+				result_ = std::forward<T>(value);
+			seen_ = true;
+			return true;
+		}
+		ResultType Result() { return std::move(result_); }
+	};
+
+	// compile-time options of a Signal, derive from it and override what you need
+	struct DefaultPolicy
+	{
+		typedef LockedDispatch Dispatch;
+		// what a connection stores its callable in, InlineFunction<Sig, Size> avoids the allocations of std::function
+		template<typename Sig>
+		using Slot = std::function<Sig>;
+		// NoMetrics, CollectMetrics or TraceMetrics
+		typedef NoMetrics Metrics;
+		// what an emission does with the results of the slots, see DiscardResults
+		template<typename R>
+		using Combiner = DiscardResults<R>;
+		// disconnected slots are left behind as tombstones, erased in one pass once they are 1/CompactRatio of the slot list
+		static const size_t CompactRatio = 4;
+		// EmitParallel hands each thread at least this many slots at once, fewer than two such chunks run on the emitting thread
+		static const size_t ParallelGrain = 4;
+		// how many stripes a SignalHub splits its signals into, each with its own lock
+		static const size_t HubShards = 16;
+		// where signals, connections and their slot lists get their memory, e.g. std::pmr::polymorphic_allocator to put them in an
+		// arena. a stateful one is given to the constructor of the Signal or SignalHub, made from Allocator<char>
+		template<typename T>
+		using Allocator = std::allocator<T>;
+	};
+
+	template<typename Access>
+	class BasicNamedObjectBase :
+		public BasicObjectBase<Access>
+	{
+	protected:
+		std::string name_;
+	public:
+		const std::string& Name(){ return name_; }
+	};
+	typedef BasicNamedObjectBase<AtomicAccess> NamedObjectBase;
+
+	template<typename Access>
+	class BasicConnectionBase :
+		public BasicNamedObjectBase<Access>
+	{
+	protected:
+		std::string sig_name_;
+	public:
+		~BasicConnectionBase(){ this->Release(); }
+		std::string SigName(){ return sig_name_; }
+	};
+	typedef BasicConnectionBase<AtomicAccess> ConnectionBase;
+
+	/*
+	contiguous storage handing out stable keys, Find is O(1) and iteration walks a dense array.
+	elements are kept sorted by the group given to Insert, each group being one contiguous range;
+	Insert and Erase swap one element per group after the one they touch, so they are O(1) with a single group.
+	the order inside a group is not preserved
+	*/
+	template<typename T, typename Alloc = std::allocator<T>>
+	class SlotMap
+	{
+	public:
+		typedef SlotKey Key;
+	private:
+		struct Slot
+		{
+			uint32_t dense;// position in items_ when used, next free slot otherwise
+			uint32_t generation;
+		};
+		struct Group
+		{
+			int id;
+			uint32_t end;// the group is items_[previous group's end, end)
+		};
+		template<typename U>
+		using Vector = std::vector<U, typename std::allocator_traits<Alloc>::template rebind_alloc<U>>;
+		static const uint32_t npos = 0xffffffff;
+		Vector<T> items_;
+		Vector<uint32_t> owners_;// items_[i] is referenced by slots_[owners_[i]]
+		Vector<Slot> slots_;
+		Vector<Group> groups_;// sorted by id, never empty ones
+		uint32_t free_ = npos;
+
+		uint32_t Begin(size_t group) const { return 0 == group ? 0 : groups_[group - 1].end; }
+		void Swap(uint32_t a, uint32_t b)
+		{
+			if (a == b)
+				return;
+			std::swap(items_[a], items_[b]);
+			std::swap(owners_[a], owners_[b]);
+			slots_[owners_[a]].dense = a;
+			slots_[owners_[b]].dense = b;
+		}
+	public:
+		explicit SlotMap(const Alloc& alloc = Alloc()) :
+			items_(alloc), owners_(alloc), slots_(alloc), groups_(alloc)
+		{}
+		// room for n elements without reallocating
+		void Reserve(size_t n)
+		{
+			items_.reserve(n);
+			owners_.reserve(n);
+			slots_.reserve(n);
+		}
+		Key Insert(T item, int group = 0)
+		{
+			auto index = free_;
+			if (npos == index)
+			{
+				index = static_cast<uint32_t>(slots_.size());
+				slots_.push_back(Slot{ 0, 0 });
+			}
+			else
+			{
+				free_ = slots_[index].dense;
+			}
+			auto dense = static_cast<uint32_t>(items_.size());
+			slots_[index].dense = dense;
+			items_.push_back(std::move(item));
+			owners_.push_back(index);
+
+			auto g = std::lower_bound(groups_.begin(), groups_.end(), group, [](const Group& l, int r) { return l.id < r; }) - groups_.begin();
+			if (static_cast<size_t>(g) == groups_.size() || groups_[g].id != group)
+				groups_.insert(groups_.begin() + g, Group{ group, Begin(g) });
+			// walk the new element down to the end of its group, the first element of each later group moves to that group's end
+			for (auto h = groups_.size() - 1; h > static_cast<size_t>(g); --h)
+			{
+				auto begin = Begin(h);
+				Swap(dense, begin);
+				dense = begin;
+				++groups_[h].end;
+			}
+			++groups_[g].end;
+			return Key{ index, slots_[index].generation };
+		}
+		// whether inserting into group moves elements, i.e. a later group has some
+		bool Moves(int group) const
+		{
+			return !groups_.empty() && groups_.back().id > group;
+		}
+		T* Find(Key key)
+		{
+			if (key.index >= slots_.size() || slots_[key.index].generation != key.generation)
+				return nullptr;
+			return &items_[slots_[key.index].dense];
+		}
+		bool Erase(Key key)
+		{
+			if (nullptr == Find(key))
+				return false;
+
+			auto&& slot = slots_[key.index];
+			auto dense = slot.dense;
+			auto g = std::upper_bound(groups_.begin(), groups_.end(), dense, [](uint32_t l, const Group& r) { return l < r.end; }) - groups_.begin();
+			// walk the hole up to the back, the last element of each group fills it and moves the hole to that group's end
+			for (auto h = static_cast<size_t>(g); h < groups_.size(); ++h)
+			{
+				auto last = --groups_[h].end;
+				Swap(dense, last);
+				dense = last;
+			}
+			if (Begin(g) == groups_[g].end)
+				groups_.erase(groups_.begin() + g);
+			items_.pop_back();
+			owners_.pop_back();
+
+			++slot.generation;
+			slot.dense = free_;
+			free_ = key.index;
+			return true;
+		}
+		// erase the elements pred holds for in a single pass, keeping the order of the others. returns how many went
+		template<typename Pred>
+		size_t EraseIf(Pred pred)
+		{
+			uint32_t kept = 0;
+			uint32_t i = 0;
+			for (auto&& group : groups_)
+			{
+				for (; i < group.end; ++i)
+				{
+					auto&& slot = slots_[owners_[i]];
+					if (pred(items_[i]))
+					{
+						++slot.generation;
+						slot.dense = free_;
+						free_ = owners_[i];
+						continue;
+					}
+					if (kept != i)
+					{
+						items_[kept] = std::move(items_[i]);
+						owners_[kept] = owners_[i];
+					}
+					slot.dense = kept++;
+				}
+				group.end = kept;
+			}
+			auto erased = items_.size() - kept;
+			items_.erase(items_.begin() + kept, items_.end());
+			owners_.resize(kept);
+
+			// drop the groups left empty
+			uint32_t begin = 0;
+			size_t used = 0;
+			for (auto&& group : groups_)
+			{
+				if (group.end != begin)
+					groups_[used++] = group;
+				begin = group.end;
+			}
+			groups_.resize(used);
+			return erased;
+		}
+		void Clear()
+		{
+			items_.clear();
+			owners_.clear();
+			slots_.clear();
+			groups_.clear();
+			free_ = npos;
+		}
+		size_t Size() const { return items_.size(); }
+		// the bytes of the arrays, not counting what the elements allocate
+		size_t MemoryUsage() const
+		{
+			return items_.capacity() * sizeof(T) + owners_.capacity() * sizeof(uint32_t) + slots_.capacity() * sizeof(Slot) + groups_.capacity() * sizeof(Group);
+		}
+		T& operator[](size_t i) { return items_[i]; }
+		typename Vector<T>::iterator begin() { return items_.begin(); }
+		typename Vector<T>::iterator end() { return items_.end(); }
+	};
+
+	// a std::function replacement keeping the callable inside the object, it never allocates.
+	// storing a callable bigger than Size bytes is a compile-time error
+	template<typename Signature, size_t Size = 32>
+	class InlineFunction;
+
+	template<typename R, typename ...Args, size_t Size>
+	class InlineFunction<R(Args...), Size>
+	{
+		enum Operation { Copy, Move, Destroy };
+		typedef R(*Invoker)(void*, Args&&...);
+		typedef void(*Manager)(Operation, void*, void*);
+
+		alignas(std::max_align_t) mutable unsigned char storage_[Size];// mutable, like the target of a std::function
+		Invoker invoke_ = nullptr;
+		Manager manage_ = nullptr;
+
+		template<typename F>
+		static R Invoke(void* f, Args&&... args)
+		{
+			return (*static_cast<F*>(f))(std::forward<Args>(args)...);
+		}
+		template<typename F>
+		static void Manage(Operation op, void* dst, void* src)
+		{
+			switch (op)
+			{
+			case Copy:
+				new (dst) F(*static_cast<const F*>(src));
+				break;
+			case Move:
+				new (dst) F(std::move(*static_cast<F*>(src)));
+				break;
+			case Destroy:
+				static_cast<F*>(dst)->~F();
+				break;
+			}
+		}
+		void Assign(Operation op, const InlineFunction& other)
+		{
+			if (other.manage_)
+				other.manage_(op, storage_, other.storage_);
+			invoke_ = other.invoke_;
+			manage_ = other.manage_;
+		}
+		void Reset()
+		{
+			if (manage_)
+				manage_(Destroy, storage_, nullptr);
+			invoke_ = nullptr;
+			manage_ = nullptr;
+		}
+	public:
+		InlineFunction() {}
+		InlineFunction(std::nullptr_t) {}
+		template<typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, InlineFunction>::value>::type>
+		InlineFunction(F&& f)
+		{
+			typedef typename std::decay<F>::type Functor;
+			static_assert(sizeof(Functor) <= Size, "the callable does not fit, increase the Size of InlineFunction");
+			static_assert(alignof(Functor) <= alignof(std::max_align_t), "the callable is over-aligned for InlineFunction");
+			new (storage_) Functor(std::forward<F>(f));
+			invoke_ = &Invoke<Functor>;
+			manage_ = &Manage<Functor>;
+		}
+		InlineFunction(const InlineFunction& other) { Assign(Copy, other); }
+		InlineFunction(InlineFunction&& other) { Assign(Move, other); }
+		~InlineFunction() { Reset(); }
+		InlineFunction& operator=(const InlineFunction& other)
+		{
+			if (this != &other)
+			{
+				Reset();
+				Assign(Copy, other);
+			}
+			return *this;
+		}
+		InlineFunction& operator=(InlineFunction&& other)
+		{
+			if (this != &other)
+			{
+				Reset();
+				Assign(Move, other);
+			}
+			return *this;
+		}
+		explicit operator bool() const { return nullptr != invoke_; }
+		R operator()(Args... args) const
+		{
+			if (nullptr == invoke_)
+				throw std::bad_function_call();
+			return invoke_(storage_, std::forward<Args>(args)...);
+		}
+	};
+
+	template<size_t ...I>
+	struct IndexSequence {};
+	template<size_t N, size_t ...I>
+	struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, I...> {};
+	template<size_t ...I>
+	struct MakeIndexSequence<0, I...> { typedef IndexSequence<I...> type; };
+
+	template<typename ...Args>
+	struct BatchItemOf { typedef std::tuple<typename std::decay<Args>::type...> type; };
+	template<typename Arg>
+	struct BatchItemOf<Arg> { typedef typename std::decay<Arg>::type type; };
+
+	template<typename Signature>
+	struct SignatureTraits;
+	template<typename R, typename ...Args>
+	struct SignatureTraits<R(Args...)>
+	{
+		typedef R Result;
+		typedef std::tuple<Args...> Arguments;
+		typedef std::tuple<typename std::decay<Args>::type...> Values;// what a queued call keeps of the arguments
+		typedef typename BatchItemOf<Args...>::type BatchItem;// an element of EmitBatch: the argument itself, or a tuple of them
+		static const size_t Arity = sizeof...(Args);
+	};
+
+	/*
+	an emission hands its arguments to the last slot as they came, moving rvalues in; the other slots get arguments
+	as lvalues, except for Arg&& parameters, which see the same object as an rvalue and leave it to the slot whether to move
+	from it. a move-only parameter taken by value would be moved out by the first slot, so it doesn't compile: declare it
+	Arg&& or const Arg&
+	*/
+	template<typename Arg>
+	struct ShareAsRvalue :
+		std::is_rvalue_reference<Arg>
+	{};
+	template<typename Arg, typename Param>
+	auto ShareArgument(Param& param) -> typename std::conditional<ShareAsRvalue<Arg>::value, Param&&, Param&>::type
+	{
+		static_assert(std::is_reference<Arg>::value || std::is_copy_constructible<typename std::decay<Arg>::type>::value,
+			"the first slot would move a move-only parameter taken by value away from the others, declare it Arg&& or const Arg&");
+		return static_cast<typename std::conditional<ShareAsRvalue<Arg>::value, Param&&, Param&>::type>(param);
+	}
+	// whether an emission must hand some argument of Signature to its slots as an rvalue, see ShareAsRvalue
+	template<typename Arguments>
+	struct SharesAsRvalue;
+	template<>
+	struct SharesAsRvalue<std::tuple<>> : std::false_type {};
+	template<typename Arg, typename ...Rest>
+	struct SharesAsRvalue<std::tuple<Arg, Rest...>> :
+		std::integral_constant<bool, ShareAsRvalue<Arg>::value || SharesAsRvalue<std::tuple<Rest...>>::value>
+	{};
+	// how a queued call hands its copy of an argument to the slot: moved in, unless the parameter is an lvalue reference
+	template<typename Arg, typename Value>
+	auto GiveArgument(Value& value) -> typename std::conditional<std::is_lvalue_reference<Arg>::value, Value&, Value&&>::type
+	{
+		return static_cast<typename std::conditional<std::is_lvalue_reference<Arg>::value, Value&, Value&&>::type>(value);
+	}
+
+	// a unit of work posted to an Executor
+	class Task
+	{
+		friend class MpscQueue;
+		std::atomic<Task*> next_{ nullptr };// the link of the MpscQueue it waits in
+	public:
+		virtual ~Task(){}
+		virtual void Run() = 0;
+	};
+
+	// runs the slots of queued signals and connections, implement it to hand them to your own event loop
+	class Executor
+	{
+	public:
+		virtual ~Executor(){}
+		virtual void Post(std::unique_ptr<Task> task) = 0;
+	};
+
+	// runs tasks right away on the emitting thread, e.g. to keep one connection of a queued signal synchronous
+	class InlineExecutor :
+		public Executor
+	{
+	public:
+		void Post(std::unique_ptr<Task> task) override { task->Run(); }
+	};
+
+#ifdef NAMEDSIGSLOT_COROUTINES
+	// resumes a coroutine waiting in Signal::Next on the executor it asked for
+	class ResumeTask :
+		public Task
+	{
+		std::coroutine_handle<> handle_;
+	public:
+		explicit ResumeTask(std::coroutine_handle<> handle) : handle_(handle) {}
+		void Run() override { handle_.resume(); }
+	};
+#endif
+
+	// bounded lock-free multi-producer multi-consumer queue (Dmitry Vyukov's design), capacity is rounded up to a power of 2
+	template<typename T>
+	class MpmcQueue
+	{
+		struct Cell
+		{
+			std::atomic<size_t> sequence;
+			T data;
+		};
+		std::vector<Cell> cells_;
+		size_t mask_;
+		char pad0_[64];// keep producers and consumers off each other's cache line
+		std::atomic<size_t> enqueue_pos_{ 0 };
+		char pad1_[64];
+		std::atomic<size_t> dequeue_pos_{ 0 };
+		char pad2_[64];
+
+		static size_t RoundUp(size_t n)
+		{
+			size_t result = 2;
+			while (result < n)
+				result <<= 1;
+			return result;
+		}
+	public:
+		explicit MpmcQueue(size_t capacity) :
+			cells_(RoundUp(capacity)), mask_(cells_.size() - 1)
+		{
+			for (size_t i = 0; i < cells_.size(); ++i)
+				cells_[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		bool TryPush(T value)
+		{
+			auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				auto&& cell = cells_[pos & mask_];
+				auto seq = cell.sequence.load(std::memory_order_acquire);
+				auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+				if (0 == diff)
+				{
+					if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						cell.data = std::move(value);
+						cell.sequence.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (diff < 0)
+					return false;// full
+				else
+					pos = enqueue_pos_.load(std::memory_order_relaxed);
+			}
+		}
+		bool TryPop(T& value)
+		{
+			auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				auto&& cell = cells_[pos & mask_];
+				auto seq = cell.sequence.load(std::memory_order_acquire);
+				auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+				if (0 == diff)
+				{
+					if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						value = std::move(cell.data);
+						cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (diff < 0)
+					return false;// empty
+				else
+					pos = dequeue_pos_.load(std::memory_order_relaxed);
+			}
+		}
+	};
+
+	/*
+	the built-in Executor: worker threads sharing one lock-free queue.
+	producers only touch the queue, and signal a condition variable when a worker is asleep;
+	a worker which wakes up keeps draining up to batch tasks before it checks whether to sleep again.
+	Post() yields while the queue is full, the destructor runs what is still queued before joining
+	*/
+	class ThreadPool :
+		public Executor
+	{
+		MpmcQueue<Task*> queue_;
+		size_t batch_;
+		std::atomic<bool> stop_{ false };
+		std::atomic<int> sleepers_{ 0 };
+		std::mutex wake_lock_;
+		std::condition_variable wake_;
+		std::vector<std::thread> threads_;
+
+		// runs up to batch_ tasks, returns how many there were
+		size_t Drain()
+		{
+			size_t count = 0;
+			Task* task = nullptr;
+			while (count < batch_ && queue_.TryPop(task))
+			{
+				std::unique_ptr<Task> owned(task);
+				owned->Run();
+				++count;
+			}
+			return count;
+		}
+		void Work()
+		{
+			for (;;)
+			{
+				if (Drain())
+					continue;
+
+				std::unique_lock<std::mutex> l(wake_lock_);
+				sleepers_.fetch_add(1);
+				Task* task = nullptr;
+				if (queue_.TryPop(task))
+				{// raced with a Post which didn't see us sleeping
+					sleepers_.fetch_sub(1);
+					l.unlock();
+					std::unique_ptr<Task> owned(task);
+					owned->Run();
+					continue;
+				}
+				if (stop_)
+				{
+					sleepers_.fetch_sub(1);
+					return;
+				}
+				wake_.wait(l);
+				sleepers_.fetch_sub(1);
+			}
+		}
+	public:
+		explicit ThreadPool(size_t threads = std::thread::hardware_concurrency(), size_t capacity = 65536, size_t batch = 64) :
+			queue_(capacity), batch_(batch ? batch : 1)
+		{
+			if (0 == threads)
+				threads = 1;
+			for (size_t i = 0; i < threads; ++i)
+				threads_.push_back(std::thread([this]{ Work(); }));
+		}
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> l(wake_lock_);
+				stop_ = true;
+			}
+			wake_.notify_all();
+			for (auto&& thread : threads_)
+				thread.join();
+		}
+		size_t Size() const { return threads_.size(); }
+		void Post(std::unique_ptr<Task> task) override
+		{
+			auto p = task.release();
+			while (!queue_.TryPush(p))
+				std::this_thread::yield();
+
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (sleepers_.load())
+			{
+				std::lock_guard<std::mutex> l(wake_lock_);
+				wake_.notify_one();
+			}
+		}
+	};
+	/*
+	calls f(begin, end) over [0, count) in chunks of grain, on the calling thread and on up to helpers tasks posted to executor,
+	whoever is free claims the next chunk; returns once all of them ran. a helper which starts late finds nothing left and
+	never touches f, so nothing waits for it and the caller may be a thread of executor itself
+	*/
+	class ParallelFor
+	{
+		struct State
+		{
+			void(*run_)(void*, size_t, size_t);
+			void* f_;
+			size_t count_;
+			size_t grain_;
+			std::atomic<size_t> next_{ 0 };// the first index not claimed yet
+			std::atomic<size_t> done_{ 0 };// how many indexes ran
+			std::mutex lock_;
+			std::condition_variable finished_;
+
+			State(void(*run)(void*, size_t, size_t), void* f, size_t count, size_t grain) : run_(run), f_(f), count_(count), grain_(grain) {}
+			void Work()
+			{
+				for (;;)
+				{
+					auto begin = next_.fetch_add(grain_, std::memory_order_relaxed);
+					if (begin >= count_)
+						return;
+					auto end = std::min(begin + grain_, count_);
+					run_(f_, begin, end);
+					if (done_.fetch_add(end - begin, std::memory_order_acq_rel) + (end - begin) == count_)
+					{
+						std::lock_guard<std::mutex> l(lock_);
+						finished_.notify_all();
+					}
+				}
+			}
+		};
+		class Helper :
+			public Task
+		{
+			std::shared_ptr<State> state_;
+		public:
+			explicit Helper(std::shared_ptr<State> state) : state_(std::move(state)) {}
+			void Run() override { state_->Work(); }
+		};
+		template<typename F>
+		static void Call(void* f, size_t begin, size_t end)
+		{
+			(*static_cast<F*>(f))(begin, end);
+		}
+	public:
+		template<typename F>
+		static void Run(Executor& executor, size_t helpers, size_t count, size_t grain, F&& f)
+		{
+			if (0 == grain)
+				grain = 1;
+			if (count <= grain || 0 == helpers)
+			{
+				if (count)
+					f(size_t(0), count);
+				return;
+			}
+			typedef typename std::remove_reference<F>::type Functor;
+			auto state = std::make_shared<State>(&Call<Functor>, static_cast<void*>(std::addressof(f)), count, grain);
+			helpers = std::min(helpers, (count - 1) / grain);// the caller takes a chunk too
+			for (size_t i = 0; i < helpers; ++i)
+				executor.Post(std::unique_ptr<Task>(new Helper(state)));
+			state->Work();
+
+			std::unique_lock<std::mutex> l(state->lock_);
+			state->finished_.wait(l, [&]{ return state->done_.load(std::memory_order_acquire) == count; });
+		}
+	};
+
+
+	// unbounded lock-free queue of tasks linked through themselves (Dmitry Vyukov's intrusive design), any thread pushes and one pops
+	class MpscQueue
+	{
+		struct Stub :
+			public Task
+		{
+			void Run() override {}
+		};
+		Stub stub_;
+		std::atomic<Task*> head_;// the last pushed
+		Task* tail_;// the next to pop, only touched by the consumer
+	public:
+		MpscQueue() : head_(&stub_), tail_(&stub_) {}
+		MpscQueue(const MpscQueue&) = delete;
+		MpscQueue& operator=(const MpscQueue&) = delete;
+		~MpscQueue()
+		{
+			while (auto task = Pop())
+				delete task;
+		}
+		// one exchange, the queue owns task until it is popped
+		void Push(Task* task)
+		{
+			task->next_.store(nullptr, std::memory_order_relaxed);
+			auto prev = head_.exchange(task, std::memory_order_acq_rel);
+			prev->next_.store(task, std::memory_order_release);
+		}
+		// nullptr when empty, or when the next task is still being pushed
+		Task* Pop()
+		{
+			auto tail = tail_;
+			auto next = tail->next_.load(std::memory_order_acquire);
+			if (&stub_ == tail)
+			{
+				if (nullptr == next)
+					return nullptr;
+				tail_ = next;
+				tail = next;
+				next = next->next_.load(std::memory_order_acquire);
+			}
+			if (nullptr != next)
+			{
+				tail_ = next;
+				return tail;
+			}
+			if (tail != head_.load(std::memory_order_acquire))
+				return nullptr;
+			// tail is the last one, put the stub behind it so it can leave
+			Push(&stub_);
+			next = tail->next_.load(std::memory_order_acquire);
+			if (nullptr == next)
+				return nullptr;
+			tail_ = next;
+			return tail;
+		}
+	};
+
+	/*
+	the Executor of a thread, its tasks run when the thread calls PumpEvents(). made for each thread on first use by Current(),
+	see Signal::ConnectAffine. posting from another thread is one push to a lock-free queue, the owner thread runs the task right away.
+	once the thread exits the mailbox drops what is posted to it, it goes away with the last connection using it
+	*/
+	class Mailbox :
+		public Executor
+	{
+		MpscQueue queue_;
+		std::thread::id owner_ = std::this_thread::get_id();
+		std::atomic<bool> closed_{ false };
+
+		// closes the mailbox of a thread when it exits
+		struct Holder
+		{
+			std::shared_ptr<Mailbox> mailbox_;
+			~Holder()
+			{
+				if (!mailbox_)
+					return;
+				mailbox_->closed_ = true;
+				while (auto task = mailbox_->queue_.Pop())
+					delete task;
+			}
+		};
+		static Holder& Here()
+		{
+			static thread_local Holder holder;
+			if (!holder.mailbox_)
+				holder.mailbox_ = std::make_shared<Mailbox>();
+			return holder;
+		}
+	public:
+		// the mailbox of the calling thread
+		static std::shared_ptr<Mailbox> Current() { return Here().mailbox_; }
+		void Post(std::unique_ptr<Task> task) override
+		{
+			if (std::this_thread::get_id() == owner_)
+				task->Run();
+			else if (!closed_.load(std::memory_order_relaxed))
+				queue_.Push(task.release());
+		}
+		// runs up to max of the tasks posted from other threads, must be called by the owner thread. returns how many ran
+		size_t Pump(size_t max = static_cast<size_t>(-1))
+		{
+			size_t count = 0;
+			while (count < max)
+			{
+				std::unique_ptr<Task> task(queue_.Pop());
+				if (!task)
+					break;
+				task->Run();
+				++count;
+			}
+			return count;
+		}
+		friend size_t PumpEvents(size_t max);
+	};
+
+	// runs the slots other threads posted to the calling thread's Mailbox, returns how many ran
+	inline size_t PumpEvents(size_t max = static_cast<size_t>(-1))
+	{
+		return Mailbox::Here().mailbox_->Pump(max);
+	}
+
+	template<typename Signature, typename Slot = std::function<Signature>, typename Access = AtomicAccess, typename Metrics = NoMetrics>
+	class Connection:
+		public BasicConnectionBase<Access>,
+		private Metrics::ConnectionCounters// empty unless metrics are collected
+	{
+		template<typename, typename, typename>
+		friend class Signal;
+		template<typename>
+		friend class ScopedConnection;
+		template<typename, typename>
+		friend class SignalHub;
+		typedef std::function<void(const typename SignatureTraits<Signature>::BatchItem*, size_t)> BatchSlot;
+		Slot slot_;
+		Executor* executor_ = nullptr;// overrides the signal's executor when set
+		std::shared_ptr<Mailbox> mailbox_;// the thread mailbox of ConnectAffine, executor_ points to it
+		int group_ = 0;// where the signal keeps and calls it, lower groups first
+		std::unique_ptr<BatchSlot> batch_slot_;// set by ConnectBatch, slot_ then forwards single emissions to it
+		typename Access::template Atomic<bool> closed_{ false };// set when its ScopedConnection goes away, the signal still holds it
+
+		typename Metrics::ConnectionCounters& Counters() { return *this; }
+		// the end of a scoped connection: no further calls start, the signal lets go of it when it compacts
+		void Close()
+		{
+			closed_ = true;
+			this->Release();
+		}
+		// calls the slot and hands its result to combiner, false stops the emission
+		template <typename Combiner, typename ...Params>
+		bool Call(Combiner& combiner, Params&&... params)
+		{
+			if (!this->Enabled())
+				return true;
+			auto start = Metrics::Start();
+			auto more = Fold(combiner, std::is_void<typename SignatureTraits<Signature>::Result>(), std::forward<Params>(params)...);
+			Metrics::Invoked(Counters(), start, *this);
+			return more;
+		}
+		template <typename Combiner, typename ...Params>
+		bool Fold(Combiner& combiner, std::false_type, Params&&... params)
+		{
+			// a batch slot returns nothing, the Result() its thunk makes up must not reach the combiner
+			if (batch_slot_)
+			{
+				slot_(std::forward<Params>(params)...);
+				return true;
+			}
+			return combiner(slot_(std::forward<Params>(params)...));
+		}
+		template <typename Combiner, typename ...Params>
+		bool Fold(Combiner&, std::true_type, Params&&... params)
+		{
+			slot_(std::forward<Params>(params)...);
+			return true;
+		}
+		template <typename ...Params>
+		void operator()(Params&&... params)
+		{
+			DiscardResults<typename SignatureTraits<Signature>::Result> discard;
+			Call(discard, std::forward<Params>(params)...);
+		}
+		template <typename ...Params>
+		void Emit(Params&&... params)
+		{
+			operator()(std::forward<Params>(params)...);
+		}
+	};
+
+	/*
+	the only handle of a connection made by Signal::ConnectScoped, it disconnects when it goes away and can be moved, not copied.
+	the signal owns the connection meanwhile, so emitting checks a flag of it instead of locking a weak reference
+	*/
+	template<typename ConnectionPtr>
+	class ScopedConnection
+	{
+		ConnectionPtr conn_;
+	public:
+		ScopedConnection() {}
+		explicit ScopedConnection(ConnectionPtr conn) : conn_(std::move(conn)) {}
+		ScopedConnection(ScopedConnection&& other) : conn_(std::move(other.conn_)) {}
+		ScopedConnection& operator=(ScopedConnection&& other)
+		{
+			if (this != &other)
+			{
+				Disconnect();
+				conn_ = std::move(other.conn_);
+			}
+			return *this;
+		}
+		ScopedConnection(const ScopedConnection&) = delete;
+		ScopedConnection& operator=(const ScopedConnection&) = delete;
+		~ScopedConnection(){ Disconnect(); }
+		void Disconnect()
+		{
+			if (conn_)
+			{
+				conn_->Close();
+				conn_.reset();
+			}
+		}
+		typename ConnectionPtr::element_type* operator->() const { return conn_.get(); }
+		explicit operator bool() const { return static_cast<bool>(conn_); }
+	};
+
+	template<typename Access>
+	class BasicSignalBase :
+		public BasicNamedObjectBase<Access>
+	{
+	public:
+		~BasicSignalBase(){ this->Release(); }
+		virtual SignalMetrics ReadMetrics()
+		{
+			SignalMetrics result;
+			result.name = this->name_;
+			return result;
+		}
+		virtual size_t MemoryUsage() { return sizeof(*this); }
+	};
+	typedef BasicSignalBase<AtomicAccess> SignalBase;
+
+	// Threading : a mutex type, MultiThreaded<Mutex> or SingleThreaded
+	template<typename Signature, typename Threading = std::recursive_mutex, typename Policy = DefaultPolicy>
+	class Signal :
+		public BasicSignalBase<typename ThreadingOf<Threading>::type::Access>,
+		private BasicOwnerBase<typename ThreadingOf<Threading>::type::Access>,
+		private Policy::Metrics::SignalCounters// empty unless metrics are collected
+	{
+	public:
+		typedef typename ThreadingOf<Threading>::type ThreadingModel;
+		typedef typename ThreadingModel::Access Access;
+		typedef typename Policy::Metrics Metrics;
+		typedef typename Policy::template Slot<Signature> SlotType;
+		typedef Connection<Signature, SlotType, Access, Metrics> ConnectionType;
+		typedef typename Policy::template Combiner<typename SignatureTraits<Signature>::Result> CombinerType;
+		typedef typename CombinerType::ResultType ResultType;// what an emission returns
+		typedef typename Access::template SharedPtr<ConnectionType> ConnectionPtr;// std::shared_ptr unless SingleThreaded
+		typedef typename SignatureTraits<Signature>::BatchItem BatchItem;
+		typedef typename ConnectionType::BatchSlot BatchSlot;
+		typedef typename Policy::template Allocator<char> AllocatorType;
+		typedef nsNamedSigslot::ScopedConnection<ConnectionPtr> ScopedConnection;// what ConnectScoped returns
+#ifdef NAMEDSIGSLOT_COROUTINES
+		class NextEmission;// what Next() returns
+#endif
+	private:
+		typedef typename Access::template WeakPtr<ConnectionType> WeakConnection;
+		// an element of the slot list, a weak reference to a shared connection or the reference of a scoped one
+		struct Entry
+		{
+			WeakConnection weak_;
+			ConnectionPtr scoped_;
+
+			Entry() {}
+			Entry(const ConnectionPtr& conn, bool scoped) : weak_(scoped ? WeakConnection() : WeakConnection(conn)), scoped_(scoped ? conn : nullptr) {}
+			// the connection while it is alive, locked keeps a shared one alive in the meantime
+			const ConnectionPtr* Lock(ConnectionPtr& locked) const
+			{
+				if (scoped_)
+					return scoped_->closed_.load(std::memory_order_relaxed) ? nullptr : &scoped_;
+				locked = weak_.lock();
+				return locked ? &locked : nullptr;
+			}
+			bool Expired() const { return scoped_ ? scoped_->closed_.load(std::memory_order_relaxed) : weak_.expired(); }
+		};
+		template<typename U>
+		using Vector = std::vector<U, typename std::allocator_traits<AllocatorType>::template rebind_alloc<U>>;
+		// an immutable copy of the slot list, published by SnapshotDispatch. emitters read it in an Access::Epoch section,
+		// the copy it replaces is freed by a later Publish once no emitter can still be reading it
+		struct SnapshotEntries
+		{
+			Vector<Entry> entries_;
+			template<typename Iterator>
+			SnapshotEntries(Iterator first, Iterator last, const AllocatorType& alloc) : entries_(first, last, alloc) {}
+		};
+		typedef typename std::allocator_traits<AllocatorType>::template rebind_alloc<SnapshotEntries> SnapshotAllocator;
+		typedef std::pair<uint64_t, SnapshotEntries*> Retired;// a replaced snapshot and its Epoch::Retire() stamp
+		template<typename, typename>
+		friend class SignalHub;
+		template<typename, typename>
+		friend class SharedSignalHub;
+		AllocatorType alloc_;
+		typename ThreadingModel::Lock lock_;
+		SlotMap<Entry, typename std::allocator_traits<AllocatorType>::template rebind_alloc<Entry>> conns_;
+		uint32_t emitting_ = 0;// nesting depth of LockedDispatch emissions, guarded by lock_
+		typename Access::template Atomic<int> tombstones_{ 0 };// expired entries of conns_, counted by Detach and erased by Compact
+		Vector<Entry> pending_connect_;// connected while emitting, placed once it is done so conns_ stays put under the emitters
+		typename Access::template Atomic<SnapshotEntries*> snapshot_{ nullptr };// only used by SnapshotDispatch, stored under lock_
+		Vector<Retired> retired_;// guarded by lock_
+		typename Access::template Atomic<Executor*> executor_{ nullptr };// slots are posted to it instead of being called, when set
+#ifdef NAMEDSIGSLOT_COROUTINES
+		typename Access::template Atomic<NextEmission*> waiters_{ nullptr };// the coroutines suspended in Next(), changed under lock_
+		NextEmission* last_waiter_ = nullptr;// guarded by lock_
+#endif
+#if defined(_DEBUG) || defined(DEBUG)
+		std::map<std::string, WeakConnection> named_conns_;
+#endif
+	public:
+		Signal() : Signal(AllocatorType()) {}
+		// alloc : where the connections and the slot list get their memory
+		explicit Signal(const AllocatorType& alloc) :
+			alloc_(alloc), conns_(alloc), pending_connect_(alloc), retired_(alloc)
+		{}
+		~Signal()
+		{
+#ifdef NAMEDSIGSLOT_COROUTINES
+			NextEmission* waiters = nullptr;
+			{
+				std::lock_guard<decltype(lock_)> l(lock_);
+				waiters = DetachWaiters();
+			}
+			// with no value
+			NextEmission::ResumeAll(waiters, nullptr);
+#endif
+			std::lock_guard<decltype(lock_)> l(lock_);
+			for (auto&& entry : conns_)
+			{
+				ConnectionPtr locked;
+				auto conn = entry.Lock(locked);
+				if (conn)
+				{// clear the callback
+					(*conn)->OnFinal();
+				}
+			}
+			// no emission can be under way any more
+			auto snapshot = snapshot_.load(std::memory_order_relaxed);
+			if (snapshot)
+				FreeSnapshot(snapshot);
+			for (auto&& item : retired_)
+				FreeSnapshot(item.second);
+		}
+		template <typename ...Params>
+		auto operator()(Params&&... params) -> ResultType
+		{
+			CombinerType combiner;
+			if (!this->Enabled())
+				return combiner.Result();
+
+			Metrics::Emitted(Counters(), *this);
+#ifdef NAMEDSIGSLOT_COROUTINES
+			// the waiters copy the arguments before the last slot may move them away, and are resumed after the slots
+			auto waiters = TakeWaiters(params...);
+#endif
+			ForEach(typename Policy::Dispatch(), [&](const ConnectionPtr& conn, bool last) -> bool
+			{
+				if (last)
+					return Invoke(conn, combiner, std::forward<Params>(params)...);
+				return InvokeShared(conn, combiner, typename MakeIndexSequence<sizeof...(Params)>::type(), params...);
+			});
+#ifdef NAMEDSIGSLOT_COROUTINES
+			NextEmission::ResumeAll(waiters, executor_.load(std::memory_order_relaxed));
+#endif
+			return combiner.Result();
+		}
+		/*
+		emit each element of [first, last), an element is the argument itself for single parameter signatures and a std::tuple
+		of the arguments otherwise. the slot list is taken once and each connection locked once, then gets the whole batch
+		before the next one does. Iterator must be a forward iterator, pass pointers to hand batch slots your storage as is
+		*/
+		template <typename Iterator>
+		void EmitBatch(Iterator first, Iterator last)
+		{
+			if (!this->Enabled() || first == last)
+				return;
+
+			Metrics::Emitted(Counters(), *this, std::distance(first, last));
+#ifdef NAMEDSIGSLOT_COROUTINES
+			// a batch is one emission for Next(), the waiters get its first item
+			auto waiters = TakeWaiters(*first);
+#endif
+			std::vector<BatchItem> copy;// made when a batch slot needs contiguous items we don't have
+			DiscardResults<typename SignatureTraits<Signature>::Result> discard;
+			ForEach(typename Policy::Dispatch(), [&](const ConnectionPtr& conn, bool) -> bool
+			{
+				if (conn->batch_slot_ && nullptr == (conn->executor_ ? conn->executor_ : executor_.load(std::memory_order_relaxed)))
+				{
+					if (conn->Enabled())
+					{
+						auto items = Contiguous(first, last, copy);
+						auto start = Metrics::Start();
+						(*conn->batch_slot_)(items.first, items.second);
+						Metrics::Invoked(conn->Counters(), start, *conn);
+					}
+					return true;
+				}
+				for (auto it = first; it != last; ++it)
+					InvokeItem(conn, discard, *it, std::integral_constant<bool, 1 == SignatureTraits<Signature>::Arity>());
+				return true;
+			});
+#ifdef NAMEDSIGSLOT_COROUTINES
+			NextEmission::ResumeAll(waiters, executor_.load(std::memory_order_relaxed));
+#endif
+		}
+		/*
+		for many heavy, independent slots: runs them on the threads of pool and the calling thread at once, returning when all ran.
+		the live slots are split in chunks of at least Policy::ParallelGrain, taken by whichever thread is free next, and a small
+		list runs on the calling thread alone. the slots run without the lock of the signal and read the same arguments
+		concurrently, so none may need them as rvalues; their results are dropped, connections with an executor are posted to it
+		*/
+		template <typename ...Params>
+		void EmitParallel(ThreadPool& pool, Params&&... params)
+		{
+			static_assert(!SharesAsRvalue<typename SignatureTraits<Signature>::Arguments>::value, "EmitParallel shares the arguments between threads");
+			static_assert(!std::is_same<Access, PlainAccess>::value, "EmitParallel runs slots on other threads, the reference counts of a SingleThreaded signal are not atomic");
+			if (!this->Enabled())
+				return;
+
+			Metrics::Emitted(Counters(), *this);
+#ifdef NAMEDSIGSLOT_COROUTINES
+			auto waiters = TakeWaiters(params...);
+#endif
+			std::vector<ConnectionPtr> conns;
+			{
+				std::lock_guard<decltype(lock_)> l(lock_);
+				conns.reserve(conns_.Size());
+				for (auto&& entry : conns_)
+				{
+					ConnectionPtr locked;
+					auto conn = entry.Lock(locked);
+					if (conn)
+						conns.push_back(*conn);
+				}
+			}
+			// about four chunks per thread, so threads which got light slots take more
+			// a copy, since std::max takes references and the policy constant has no definition out of its class
+			const size_t min_grain = Policy::ParallelGrain;
+			auto threads = pool.Size() + 1;
+			auto grain = std::max(min_grain, (conns.size() + threads * 4 - 1) / (threads * 4));
+			ParallelFor::Run(pool, pool.Size(), conns.size(), grain, [&](size_t begin, size_t end)
+			{
+				DiscardResults<typename SignatureTraits<Signature>::Result> discard;
+				for (auto i = begin; i < end; ++i)
+					InvokeShared(conns[i], discard, typename MakeIndexSequence<sizeof...(Params)>::type(), params...);
+			});
+#ifdef NAMEDSIGSLOT_COROUTINES
+			NextEmission::ResumeAll(waiters, executor_.load(std::memory_order_relaxed));
+#endif
+		}
+		template <typename ...Params>
+		auto Emit(Params&&... params) -> ResultType
+		{
+			return operator()(std::forward<Params>(params)...);
+		}
+		// what Policy::Metrics collected for the signal and its live connections, all zero with NoMetrics
+		SignalMetrics ReadMetrics() override
+		{
+			SignalMetrics result;
+			result.name = this->name_;
+			Metrics::Read(Counters(), result);
+			std::lock_guard<decltype(lock_)> l(lock_);
+			for (auto&& entry : conns_)
+			{
+				ConnectionPtr locked;
+				auto conn = entry.Lock(locked);
+				if (!conn)
+					continue;
+				auto&& locked_conn = *conn;
+				SlotMetrics slot;
+				slot.name = locked_conn->Name();
+				Metrics::Read(locked_conn->Counters(), slot);
+				result.slots.push_back(std::move(slot));
+			}
+			return result;
+		}
+		// about the bytes the signal holds: itself, its slot lists and its connections, without what their callables allocate
+		size_t MemoryUsage() override
+		{
+			std::lock_guard<decltype(lock_)> l(lock_);
+			size_t result = sizeof(*this) + conns_.MemoryUsage() + pending_connect_.capacity() * sizeof(Entry);
+			auto snapshot = snapshot_.load(std::memory_order_relaxed);
+			if (snapshot)
+				result += sizeof(SnapshotEntries) + snapshot->entries_.capacity() * sizeof(Entry);
+			for (auto&& item : retired_)
+				result += sizeof(SnapshotEntries) + item.second->entries_.capacity() * sizeof(Entry);
+			result += retired_.capacity() * sizeof(Retired);
+			for (auto&& entry : conns_)
+			{
+				ConnectionPtr locked;
+				auto conn = entry.Lock(locked);
+				if (conn)
+					result += sizeof(ConnectionType) + ((*conn)->batch_slot_ ? sizeof(BatchSlot) : 0);
+			}
+			return result;
+		}
+		/*
+		queue the slot invocations of further emissions to executor instead of running them on the emitting thread
+		the arguments are copied, nullptr goes back to synchronous dispatch. executor must outlive the signal
+		*/
+		void SetExecutor(Executor* executor)
+		{
+			executor_ = executor;
+		}
+		// save the return value as long as you want to keep the connection
+		// executor : optional, overrides the signal's executor for this connection
+		auto Connect(SlotType func, std::string name = "", Executor* executor = nullptr) -> ConnectionPtr
+		{
+			return Connect(std::move(func), 0, std::move(name), executor);
+		}
+		// group : the slots of lower groups are called first, the order within a group is unspecified. Connect() uses 0
+		auto Connect(SlotType func, int group, std::string name = "", Executor* executor = nullptr) -> ConnectionPtr
+		{
+			auto result = MakeConnection(std::move(func), group, std::move(name), executor);
+			ConnectInternal(result);
+			return result;
+		}
+		/*
+		a member function of object, Connect<&Receiver::OnValue>(this) with C++17 and Connect<decltype(&Receiver::OnValue),
+		&Receiver::OnValue>(this) before it. the slot holds the object pointer alone and calls the method directly, no allocation.
+		when Class derives from Trackable, object keeps the connection and disconnects it when it goes away; keep the result otherwise
+		*/
+#if defined(__cpp_nontype_template_parameter_auto) && __cpp_nontype_template_parameter_auto >= 201606L
+		template<auto method, typename Class>
+		auto Connect(Class* object, std::string name = "", Executor* executor = nullptr) -> ConnectionPtr
+		{
+			return Connect<decltype(method), method>(object, 0, std::move(name), executor);
+		}
+		template<auto method, typename Class>
+		auto Connect(Class* object, int group, std::string name = "", Executor* executor = nullptr) -> ConnectionPtr
+		{
+			return Connect<decltype(method), method>(object, group, std::move(name), executor);
+		}
+#endif
+		template<typename Method, Method method, typename Class>
+		auto Connect(Class* object, std::string name = "", Executor* executor = nullptr) -> ConnectionPtr
+		{
+			return Connect<Method, method>(object, 0, std::move(name), executor);
+		}
+		template<typename Method, Method method, typename Class>
+		auto Connect(Class* object, int group, std::string name = "", Executor* executor = nullptr) -> ConnectionPtr
+		{
+			auto result = Connect(SlotType(MemberSlot<Method, method, Class>{ object }), group, std::move(name), executor);
+			Track(object, result, std::is_base_of<BasicTrackableBase<Access>, Class>());
+			return result;
+		}
+		// like Connect, but the returned handle is the only one of the connection and can't be shared
+		auto ConnectScoped(SlotType func, std::string name = "", Executor* executor = nullptr) -> ScopedConnection
+		{
+			return ConnectScoped(std::move(func), 0, std::move(name), executor);
+		}
+		auto ConnectScoped(SlotType func, int group, std::string name = "", Executor* executor = nullptr) -> ScopedConnection
+		{
+			auto result = MakeConnection(std::move(func), group, std::move(name), executor);
+			ConnectInternal(result, true);
+			return ScopedConnection(std::move(result));
+		}
+		/*
+		like Connect, but the slot runs on the calling thread: emissions from other threads post it with copies of the arguments
+		to the Mailbox of this thread, which runs it in PumpEvents(). emissions from this thread call it right away
+		*/
+		auto ConnectAffine(SlotType func, std::string name = "") -> ConnectionPtr
+		{
+			return ConnectAffine(std::move(func), 0, std::move(name));
+		}
+		auto ConnectAffine(SlotType func, int group, std::string name = "") -> ConnectionPtr
+		{
+			static_assert(!std::is_same<Access, PlainAccess>::value, "ConnectAffine is for slots emitted from other threads, the reference counts of a SingleThreaded signal are not atomic");
+			auto mailbox = Mailbox::Current();
+			auto result = MakeConnection(std::move(func), group, std::move(name), mailbox.get());
+			result->mailbox_ = std::move(mailbox);
+			ConnectInternal(result);
+			return result;
+		}
+		// the slot gets each EmitBatch as one span of items, other emissions arrive as a batch of one
+		auto ConnectBatch(BatchSlot func, std::string name = "", Executor* executor = nullptr) -> ConnectionPtr
+		{
+			auto result = Access::template AllocateShared<ConnectionType>(alloc_);
+			result->batch_slot_.reset(new BatchSlot(std::move(func)));
+			result->slot_ = BatchThunk{ result->batch_slot_.get() };
+			result->executor_ = executor;
+			result->name_ = name;
+			result->sig_name_ = this->name_;
+			ConnectInternal(result);
+			return result;
+		}
+#ifdef NAMEDSIGSLOT_COROUTINES
+		/*
+		co_await it to suspend until the next emission, which resumes with a copy of its arguments: the argument itself for single
+		parameter signatures and a std::tuple of them otherwise, std::nullopt when the signal goes away first.
+		the awaiter lives in the coroutine frame and is linked into the signal, no connection is made and nothing is allocated.
+		executor : optional, where to resume; the signal's executor if not set, the emitting thread, after the slots, if neither is.
+		a coroutine destroyed while waiting unlinks itself, it must not be destroyed concurrently with the signal
+		*/
+		auto Next(Executor* executor = nullptr) -> NextEmission
+		{
+			return NextEmission(this, nullptr, executor);
+		}
+		class NextEmission
+		{
+			friend class Signal;
+			template<typename, typename>
+			friend class SignalHub;
+			typedef typename Access::template SharedPtr<Signal> SignalPtr;
+
+			Signal* signal_;// nullptr resumes right away with no value
+			SignalPtr keep_;// keeps a signal found by name alive until we are linked to it
+			Executor* executor_;
+			std::coroutine_handle<> handle_;
+			std::optional<BatchItem> value_;
+			typename Access::template Atomic<Signal*> linked_{ nullptr };// the signal while we are in its list of waiters
+			NextEmission* prev_ = nullptr;// guarded by the lock_ of linked_
+			NextEmission* next_ = nullptr;
+
+			NextEmission(Signal* signal, SignalPtr keep, Executor* executor) :
+				signal_(signal), keep_(std::move(keep)), executor_(executor)
+			{
+				static_assert(std::is_copy_constructible<BatchItem>::value, "Next() hands out copies of the arguments");
+			}
+			// must be called with the lock_ of linked_ held
+			void Unlink()
+			{
+				auto signal = linked_.load(std::memory_order_relaxed);
+				if (prev_)
+					prev_->next_ = next_;
+				else
+					signal->waiters_.store(next_, std::memory_order_relaxed);
+				if (next_)
+					next_->prev_ = prev_;
+				else
+					signal->last_waiter_ = prev_;
+				linked_.store(nullptr, std::memory_order_relaxed);
+			}
+			// resumes the waiters detached by TakeWaiters, each may destroy itself
+			static void ResumeAll(NextEmission* waiter, Executor* fallback)
+			{
+				while (nullptr != waiter)
+				{
+					auto next = waiter->next_;
+					auto executor = waiter->executor_ ? waiter->executor_ : fallback;
+					if (executor)
+						executor->Post(std::unique_ptr<Task>(new ResumeTask(waiter->handle_)));
+					else
+						waiter->handle_.resume();
+					waiter = next;
+				}
+			}
+		public:
+			NextEmission(const NextEmission&) = delete;
+			NextEmission& operator=(const NextEmission&) = delete;
+			~NextEmission()
+			{
+				auto signal = linked_.load(std::memory_order_acquire);
+				if (nullptr == signal)
+					return;
+				std::lock_guard<decltype(signal->lock_)> l(signal->lock_);
+				if (linked_.load(std::memory_order_relaxed))
+					Unlink();
+			}
+			bool await_ready() const { return nullptr == signal_; }
+			void await_suspend(std::coroutine_handle<> handle)
+			{
+				handle_ = handle;
+				auto keep = std::move(keep_);
+				{
+					std::lock_guard<decltype(signal_->lock_)> l(signal_->lock_);
+					prev_ = signal_->last_waiter_;
+					next_ = nullptr;
+					if (prev_)
+						prev_->next_ = this;
+					else
+						signal_->waiters_.store(this, std::memory_order_release);
+					signal_->last_waiter_ = this;
+					linked_.store(signal_, std::memory_order_relaxed);
+				}
+				// keep goes away last: when it held the last reference, ~Signal resumes us before we return
+			}
+			std::optional<BatchItem> await_resume() { return std::move(value_); }
+		};
+#endif
+		// this is not required, you can reset conn to disconnect
+// 		void Disconnect(std::shared_ptr<Connection<Signature>> conn)
+// 		{
+// 			std::lock_guard<decltype(lock_)> l(lock_);
+// 			auto iter = std::find_if(conns_.begin(), conns_.end(), [&conn](std::weak_ptr<Connection<Signature>> l){
+// 				auto lconn = l.lock();
+// 				return (lconn == conn);
+// 			});
+// 			if (conns_.end() != iter)
+// 				conns_.erase(iter);
+// 		}
+// 		void DisconnectAll()
+// 		{
+// 			std::lock_guard<decltype(lock_)> l(lock_);
+// 			conns_.clear();
+// 		}
+	protected:
+		typename Metrics::SignalCounters& Counters() { return *this; }
+		// a receiver deriving from Trackable keeps its member connections
+		template<typename Class>
+		static void Track(Class* object, const ConnectionPtr& conn, std::true_type)
+		{
+			static_cast<BasicTrackableBase<Access>*>(object)->Track(conn);
+		}
+		template<typename Class>
+		static void Track(Class*, const ConnectionPtr&, std::false_type)
+		{
+			static_assert(!std::is_base_of<BasicTrackableBase<AtomicAccess>, Class>::value && !std::is_base_of<BasicTrackableBase<PlainAccess>, Class>::value,
+				"the Trackable of the receiver must be SingleThreaded when the signal is, and not otherwise");
+		}
+		auto MakeConnection(SlotType func, int group, std::string name, Executor* executor) -> ConnectionPtr
+		{
+			// the connection and its control block share one allocation, disconnecting is done by ~ConnectionBase
+			auto result = Access::template AllocateShared<ConnectionType>(alloc_);
+			result->slot_ = std::move(func);
+			result->executor_ = executor;
+			result->group_ = group;
+			result->name_ = std::move(name);
+			result->sig_name_ = this->name_;
+			return result;
+		}
+		// a slot invocation posted to an Executor, holds copies of the arguments
+		class QueuedCall :
+			public Task
+		{
+			typedef typename SignatureTraits<Signature>::Values Values;
+			WeakConnection conn_;
+			Values values_;
+
+			template<size_t ...I>
+			void Call(ConnectionType& conn, IndexSequence<I...>)
+			{
+				// runs once, the values are ours to give away
+				conn(GiveArgument<typename std::tuple_element<I, typename SignatureTraits<Signature>::Arguments>::type>(std::get<I>(values_))...);
+			}
+		public:
+			template <typename ...Params>
+			QueuedCall(const ConnectionPtr& conn, Params&&... params) :
+				conn_(conn), values_(std::forward<Params>(params)...)
+			{}
+			void Run() override
+			{
+				auto conn = conn_.lock();
+				if (conn && !conn->closed_)
+					Call(*conn, typename MakeIndexSequence<std::tuple_size<Values>::value>::type());
+			}
+		};
+#ifdef NAMEDSIGSLOT_COROUTINES
+		// detaches the list of waiters of Next() and gives each a copy of the arguments, resume them with NextEmission::ResumeAll
+		template <typename ...Params>
+		NextEmission* TakeWaiters(Params&... params)
+		{
+			if constexpr (!std::is_constructible<BatchItem, Params&...>::value)
+				return nullptr;// nobody can wait for move-only arguments
+			else
+			{
+				if (nullptr == waiters_.load(std::memory_order_acquire))
+					return nullptr;
+				std::lock_guard<decltype(lock_)> l(lock_);
+				auto result = DetachWaiters();
+				for (auto waiter = result; nullptr != waiter; waiter = waiter->next_)
+					waiter->value_.emplace(params...);
+				return result;
+			}
+		}
+		// must be called with lock_ held
+		NextEmission* DetachWaiters()
+		{
+			auto result = waiters_.load(std::memory_order_relaxed);
+			for (auto waiter = result; nullptr != waiter; waiter = waiter->next_)
+				waiter->linked_.store(nullptr, std::memory_order_relaxed);
+			waiters_.store(nullptr, std::memory_order_relaxed);
+			last_waiter_ = nullptr;
+			return result;
+		}
+#endif
+		// the slot_ of a batch connection
+		struct BatchThunk
+		{
+			BatchSlot* batch_slot_;
+			template <typename ...Params>
+			typename SignatureTraits<Signature>::Result operator()(Params&&... params) const
+			{
+				auto item = BatchItem(std::forward<Params>(params)...);
+				(*batch_slot_)(&item, 1);
+				return typename SignatureTraits<Signature>::Result();
+			}
+		};
+		static std::pair<const BatchItem*, size_t> Contiguous(const BatchItem* first, const BatchItem* last, std::vector<BatchItem>&)
+		{
+			return std::make_pair(first, static_cast<size_t>(last - first));
+		}
+		static std::pair<const BatchItem*, size_t> Contiguous(BatchItem* first, BatchItem* last, std::vector<BatchItem>&)
+		{
+			return std::make_pair(const_cast<const BatchItem*>(first), static_cast<size_t>(last - first));
+		}
+		template <typename Iterator>
+		static std::pair<const BatchItem*, size_t> Contiguous(Iterator first, Iterator last, std::vector<BatchItem>& copy)
+		{
+			if (copy.empty())
+				copy.assign(first, last);
+			return std::make_pair(const_cast<const BatchItem*>(copy.data()), copy.size());
+		}
+		template <typename Combiner, typename Item>
+		bool InvokeItem(const ConnectionPtr& conn, Combiner& combiner, const Item& item, std::true_type)
+		{
+			return Invoke(conn, combiner, item);
+		}
+		template <typename Combiner, typename ...T>
+		bool InvokeItem(const ConnectionPtr& conn, Combiner& combiner, const std::tuple<T...>& item, std::false_type)
+		{
+			return InvokeTuple(conn, combiner, item, typename MakeIndexSequence<sizeof...(T)>::type());
+		}
+		template <typename Combiner, typename Tuple, size_t ...I>
+		bool InvokeTuple(const ConnectionPtr& conn, Combiner& combiner, const Tuple& item, IndexSequence<I...>)
+		{
+			return Invoke(conn, combiner, std::get<I>(item)...);
+		}
+		template <typename Combiner, size_t ...I, typename ...Params>
+		bool InvokeShared(const ConnectionPtr& conn, Combiner& combiner, IndexSequence<I...>, Params&... params)
+		{
+			return Invoke(conn, combiner, ShareArgument<typename std::tuple_element<I, typename SignatureTraits<Signature>::Arguments>::type>(params)...);
+		}
+		// false when the combiner stops the emission
+		template <typename Combiner, typename ...Params>
+		bool Invoke(const ConnectionPtr& conn, Combiner& combiner, Params&&... params)
+		{
+			auto executor = conn->executor_ ? conn->executor_ : executor_.load(std::memory_order_relaxed);
+			if (nullptr == executor)
+				return conn->Call(combiner, std::forward<Params>(params)...);
+			if (conn->Enabled())
+				executor->Post(std::unique_ptr<Task>(new QueuedCall(conn, std::forward<Params>(params)...)));
+			return true;
+		}
+		// calls f(conn, last) for the live connections, until it returns false
+		template <typename F>
+		void ForEach(LockedDispatch, F&& f)
+		{
+			std::lock_guard<decltype(lock_)> l(lock_);
+			EmittingGuard guard(*this);
+
+			// index based, slots may connect while we are walking the array, they are called from the next emission on;
+			// expired connections stay in place as tombstones and are skipped
+			auto count = conns_.Size();
+			for (size_t i = 0; i < count; ++i)
+			{
+				ConnectionPtr locked;
+				auto conn = conns_[i].Lock(locked);
+				if (conn && !f(*conn, i + 1 == count))
+					break;
+			}
+		}
+		// keeps conns_ from being reordered by disconnects and grouped connects while LockedDispatch walks it
+		struct EmittingGuard
+		{
+			Signal& signal_;
+			EmittingGuard(Signal& signal) : signal_(signal) { ++signal_.emitting_; }
+			~EmittingGuard()
+			{
+				if (0 != --signal_.emitting_)
+					return;
+				signal_.Compact();
+				for (auto&& entry : signal_.pending_connect_)
+					signal_.Place(std::move(entry));
+				signal_.pending_connect_.clear();
+				signal_.Publish(typename Policy::Dispatch());
+			}
+		};
+		template <typename F>
+		void ForEach(SnapshotDispatch, F&& f)
+		{
+			size_t count = 0;
+			{
+				// no lock and no reference count on the snapshot, it stays while we are in the section; the entries are
+				// locked one by one below, as with LockedDispatch
+				typename Access::Epoch::Guard guard;
+				auto snapshot = snapshot_.load(std::memory_order_seq_cst);
+				if (!snapshot)
+					return;
+
+				// expired connections are skipped, they leave the snapshot when the next compaction publishes a new one
+				count = snapshot->entries_.size();
+				for (size_t i = 0; i < count; ++i)
+				{
+					ConnectionPtr locked;
+					auto conn = snapshot->entries_[i].Lock(locked);
+					if (conn && !f(*conn, i + 1 == count))
+						break;
+				}
+			}
+
+			// no slot runs under lock_ here, so emitters can compact; one already being done or a Connect in progress is not waited for
+			if (Crowded(tombstones_.load(std::memory_order_relaxed), count))
+			{
+				std::unique_lock<decltype(lock_)> l(lock_, std::try_to_lock);
+				if (l.owns_lock())
+					Compact();
+			}
+		}
+		// must be called with lock_ held
+		void Publish(LockedDispatch)
+		{
+		}
+		void Publish(SnapshotDispatch)
+		{
+			SnapshotAllocator alloc(alloc_);
+			auto snapshot = std::allocator_traits<SnapshotAllocator>::allocate(alloc, 1);
+			new (snapshot) SnapshotEntries(conns_.begin(), conns_.end(), alloc_);
+			auto old = snapshot_.load(std::memory_order_relaxed);
+			snapshot_.store(snapshot, std::memory_order_seq_cst);
+			if (old)
+				retired_.push_back(Retired(Access::Epoch::Retire(), old));
+
+			// free the replaced snapshots no emitter can be reading any more, usually all of them
+			auto oldest = Access::Epoch::Oldest();
+			size_t kept = 0;
+			for (auto&& item : retired_)
+			{
+				if (item.first < oldest)
+					FreeSnapshot(item.second);
+				else
+					retired_[kept++] = item;
+			}
+			retired_.resize(kept);
+		}
+		void FreeSnapshot(SnapshotEntries* snapshot)
+		{
+			SnapshotAllocator alloc(alloc_);
+			snapshot->~SnapshotEntries();
+			std::allocator_traits<SnapshotAllocator>::deallocate(alloc, snapshot, 1);
+		}
+		// scoped : conns_ holds the only reference of conn besides its ScopedConnection
+		void ConnectInternal(ConnectionPtr conn, bool scoped = false)
+		{
+			ConnectInternal(&conn, &conn + 1, scoped);
+		}
+		// connects [first, last) under one lock and publishes the slot list once, see SignalHub::ConnectMany
+		void ConnectInternal(const ConnectionPtr* first, const ConnectionPtr* last, bool scoped = false)
+		{
+			std::lock_guard<decltype(lock_)> l(lock_);
+			Compact();
+			if (emitting_)
+			{
+				for (auto it = first; it != last; ++it)
+					pending_connect_.push_back(Entry(*it, scoped));// without an owner until it is placed, so it can go away unnoticed
+			}
+			else
+			{
+				conns_.Reserve(conns_.Size() + (last - first));
+				for (auto it = first; it != last; ++it)
+					Place(Entry(*it, scoped));
+				Publish(typename Policy::Dispatch());
+			}
+
+#if defined(_DEBUG) || defined(DEBUG)
+			for (auto it = first; it != last; ++it)
+			{
+				auto&& conn = *it;
+				auto name = conn->Name();
+				if (name.size())
+				{
+					auto conn_iter = named_conns_.find(name);
+					if (conn_iter != named_conns_.end())
+					{
+						auto old_conn = conn_iter->second.lock();
+						assert(nullptr == old_conn || old_conn->closed_); // an old instance is still valid
+					}
+					named_conns_[name] = conn;
+				}
+			}
+#endif
+		}
+		// must be called with lock_ held, Publish once done placing
+		void Place(Entry entry)
+		{
+			ConnectionPtr locked;
+			auto conn = entry.Lock(locked);
+			if (!conn)
+				return;// went away before it was placed
+			auto raw = conn->get();
+			raw->key_ = conns_.Insert(std::move(entry), raw->group_);
+			raw->owner_ = this;
+		}
+		static bool Crowded(int tombstones, size_t size)
+		{
+			return tombstones > 0 && static_cast<size_t>(tombstones) * Policy::CompactRatio >= size;
+		}
+		// erase the expired connections in one pass once there are enough of them, must be called with lock_ held
+		void Compact()
+		{
+			if (emitting_ || !Crowded(tombstones_.load(std::memory_order_relaxed), conns_.Size()))
+				return;
+
+			// a connection expires before its destructor counts it, so this may erase more than were counted
+			auto erased = conns_.EraseIf([](const Entry& entry) { return entry.Expired(); });
+			tombstones_.fetch_sub(static_cast<int>(erased), std::memory_order_relaxed);
+#if defined(_DEBUG) || defined(DEBUG)
+			for (auto iter = named_conns_.begin(); iter != named_conns_.end();)
+				iter = iter->second.expired() ? named_conns_.erase(iter) : std::next(iter);
+#endif
+			Publish(typename Policy::Dispatch());
+		}
+		/*
+		called by the connection's destructor, from any thread and possibly in the middle of an emission.
+		only the count of tombstones is bumped, the entry itself stays in conns_ until it is compacted
+		*/
+		void Detach(BasicObjectBase<Access>*, SlotKey) override
+		{
+			tombstones_.fetch_add(1, std::memory_order_relaxed);
+		}
+	};
+	/*
+	a Signal for updates which come faster than they are worth delivering: emitting stores the arguments in place of the previous
+	ones and calls no slot, Flush() delivers the latest ones, if any came since the previous Flush, through the usual emission.
+	call Flush() from a timer or from the consumer's loop, e.g. before PumpEvents(); emitting through a Signal& is not coalesced
+	*/
+	template<typename Signature, typename Threading = std::recursive_mutex, typename Policy = DefaultPolicy>
+	class CoalescingSignal :
+		public Signal<Signature, Threading, Policy>
+	{
+		typedef Signal<Signature, Threading, Policy> Base;
+		typedef typename SignatureTraits<Signature>::Values Values;
+		typename Base::ThreadingModel::Lock value_lock_;
+		typename std::aligned_storage<sizeof(Values), alignof(Values)>::type latest_;// constructed by the first emission
+		bool stored_ = false;// guarded by value_lock_
+		bool pending_ = false;// emitted since the last Flush
+
+		Values* Latest() { return reinterpret_cast<Values*>(&latest_); }
+		template<typename Value>
+		void Store(Value&& value)
+		{
+			std::lock_guard<decltype(value_lock_)> l(value_lock_);
+			if (stored_)
+				*Latest() = std::forward<Value>(value);
+			else
+			{
+				new (&latest_) Values(std::forward<Value>(value));
+				stored_ = true;
+			}
+			pending_ = true;
+		}
+		void StoreItem(const typename Base::BatchItem& item, std::true_type) { Store(Values(item)); }
+		void StoreItem(const typename Base::BatchItem& item, std::false_type) { Store(item); }
+		template<size_t ...I>
+		void Deliver(Values& values, IndexSequence<I...>)
+		{
+			Base::operator()(GiveArgument<typename std::tuple_element<I, typename SignatureTraits<Signature>::Arguments>::type>(std::get<I>(values))...);
+		}
+	public:
+		CoalescingSignal() = default;
+		explicit CoalescingSignal(const typename Base::AllocatorType& alloc) : Base(alloc) {}
+		CoalescingSignal(const CoalescingSignal&) = delete;
+		CoalescingSignal& operator=(const CoalescingSignal&) = delete;
+		~CoalescingSignal()
+		{
+			if (stored_)
+				Latest()->~Values();
+		}
+		// keeps a copy of the arguments until the next Flush, an earlier one not flushed yet is dropped
+		template <typename ...Params>
+		void operator()(Params&&... params)
+		{
+			if (this->Enabled())
+				Store(Values(std::forward<Params>(params)...));
+		}
+		template <typename ...Params>
+		void Emit(Params&&... params)
+		{
+			operator()(std::forward<Params>(params)...);
+		}
+		// only the last element of [first, last) is kept
+		template <typename Iterator>
+		void EmitBatch(Iterator first, Iterator last)
+		{
+			if (first == last || !this->Enabled())
+				return;
+			auto item = first;
+			while (++first != last)
+				item = first;
+			StoreItem(*item, std::integral_constant<bool, 1 == SignatureTraits<Signature>::Arity>());
+		}
+		// emits the latest arguments if there were any since the previous Flush, returns whether it did
+		bool Flush()
+		{
+			std::unique_lock<decltype(value_lock_)> l(value_lock_);
+			if (!pending_)
+				return false;
+			pending_ = false;
+			Values values(std::move(*Latest()));
+			l.unlock();
+			Deliver(values, typename MakeIndexSequence<std::tuple_size<Values>::value>::type());
+			return true;
+		}
+		// whether an emission is waiting for Flush
+		bool Pending()
+		{
+			std::lock_guard<decltype(value_lock_)> l(value_lock_);
+			return pending_;
+		}
+	};
+	/*
+	a utility class to hold all connections/signals
+	Enable() switches all the objects saved to it, objects whose owner went away are dropped as it grows
+	*/
+	template<typename Element, typename Threading = std::recursive_mutex, typename Allocator = std::allocator<char>>
+	class ObjectContainer
+	{
+		typedef typename ThreadingOf<Threading>::type ThreadingModel;
+		typedef typename ThreadingModel::template SharedPtr<Element> ElementPtr;
+		typedef BasicEnableGate<typename ThreadingModel::Access> Gate;
+		typename ThreadingModel::Lock lock_;
+		std::vector<ElementPtr, typename std::allocator_traits<Allocator>::template rebind_alloc<ElementPtr>> items_;
+		size_t prune_at_ = 16;// items_ is swept for orphans when it reaches this size
+		Gate* gate_ = new Gate;
+
+		void Prune()
+		{
+			items_.erase(std::remove_if(items_.begin(), items_.end(), [](const ElementPtr& item) { return item->Orphaned(); }), items_.end());
+			prune_at_ = std::max<size_t>(16, items_.size() * 2);
+		}
+	public:
+		ObjectContainer() = default;
+		explicit ObjectContainer(const Allocator& alloc) : items_(alloc) {}
+		ObjectContainer(const ObjectContainer&) = delete;
+		ObjectContainer& operator=(const ObjectContainer&) = delete;
+		~ObjectContainer(){ gate_->Release(); }
+		// an object saved to several containers follows the one switched last
+		void Save(ElementPtr item)
+		{
+			item->Join(gate_);
+			std::lock_guard<decltype(lock_)> l(lock_);
+			if (items_.size() >= prune_at_)
+				Prune();
+			items_.push_back(std::move(item));
+		}
+		// sets every saved object as a single store whatever their number; a later Enable() of an object, or EnableIf(), overrides it
+		void Enable(bool enable=true)
+		{
+			gate_->Enable(enable);
+		}
+		template<typename Comp>
+		void EnableIf(Comp comp, bool enable=true)
+		{
+			std::lock_guard<decltype(lock_)> l(lock_);
+			for (auto&& item : items_)
+			{
+				if (comp(item))
+				{
+					item->Enable(enable);
+				}
+			}
+		}
+		// use std::shared_ptr, release the object to disconnect all
+// 		void DisconnectAll()
+// 		{
+// 			std::lock_guard<decltype(lock_)> l(lock_);
+// 			items_.clear();
+// 		}
+	};
+
+	// identifies a signal of a SignalHub by the 64 bits FNV-1a hash of its name, and carries a view of the name.
+	// make them once and reuse them: "name"_sig is hashed at compile time and Intern() keeps runtime names alive,
+	// strings convert implicitly, the view is then only valid during the call it is passed to
+	class SignalId
+	{
+		uint64_t hash_;
+		const char* name_;
+		size_t size_;
+
+		static constexpr uint64_t Fnv1a(const char* s, size_t n, uint64_t h)
+		{
+			return 0 == n ? h : Fnv1a(s + 1, n - 1, (h ^ static_cast<unsigned char>(*s)) * 1099511628211ULL);
+		}
+		static uint64_t RuntimeFnv1a(const char* s, size_t n)
+		{
+			uint64_t h = 14695981039346656037ULL;
+			for (size_t i = 0; i < n; ++i)
+				h = (h ^ static_cast<unsigned char>(s[i])) * 1099511628211ULL;
+			return h;
+		}
+	public:
+		constexpr SignalId(const char* name, size_t size) :
+			hash_(Fnv1a(name, size, 14695981039346656037ULL)), name_(name), size_(size)
+		{}
+		SignalId(const char* name) :
+			hash_(RuntimeFnv1a(name, std::strlen(name))), name_(name), size_(std::strlen(name))
+		{}
+		SignalId(const std::string& name) :
+			hash_(RuntimeFnv1a(name.data(), name.size())), name_(name.data()), size_(name.size())
+		{}
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+		SignalId(std::string_view name) :
+			hash_(RuntimeFnv1a(name.data(), name.size())), name_(name.data()), size_(name.size())
+		{}
+#endif
+		constexpr uint64_t Hash() const { return hash_; }
+		std::string Name() const { return std::string(name_, size_); }
+		// whether name, a std::basic_string of any allocator, is ours, without copying it
+		template<typename String>
+		bool Is(const String& name) const { return name.size() == size_ && 0 == name.compare(0, size_, name_, size_); }
+		bool Is(const char* name) const { return 0 == std::strncmp(name, name_, size_) && '\0' == name[size_]; }
+	};
+
+	namespace literals
+	{
+		constexpr SignalId operator"" _sig(const char* name, size_t size)
+		{
+			return SignalId(name, size);
+		}
+	}
+
+	// keeps a copy of the name until the program exits, so the returned id can be stored and reused
+	inline SignalId Intern(const std::string& name)
+	{
+		static std::mutex lock;
+		static std::set<std::string> names;
+		std::lock_guard<std::mutex> l(lock);
+		return SignalId(*names.insert(name).first);
+	}
+
+	// open addressing hash table for keys which already are good hashes (see SignalId), linear probing
+	// with backward shift deletion, so a lookup is a short scan of a contiguous array and there are no tombstones.
+	// the array comes from Alloc, and so do the values which take an allocator, e.g. a SlotMap
+	template<typename T, typename Alloc = std::allocator<T>>
+	class FlatHashMap
+	{
+	public:
+		typedef std::pair<uint64_t, T> value_type;
+	private:
+		struct Bucket
+		{
+			bool used;
+			typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type storage;// holds item when used
+			value_type& Item() { return *reinterpret_cast<value_type*>(&storage); }
+		};
+		typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Bucket> BucketAlloc;
+		BucketAlloc alloc_;
+		Bucket* buckets_ = nullptr;
+		size_t capacity_ = 0;// 0 or a power of 2
+		size_t size_ = 0;
+
+		size_t Home(uint64_t hash) const
+		{
+			hash ^= hash >> 32;
+			return static_cast<size_t>((hash * 0x9E3779B97F4A7C15ULL) >> 32) & (capacity_ - 1);
+		}
+		size_t Next(size_t i) const { return (i + 1) & (capacity_ - 1); }
+		// index of the bucket holding hash, or of the empty bucket where it would go
+		size_t Probe(uint64_t hash) const
+		{
+			auto i = Home(hash);
+			while (buckets_[i].used && buckets_[i].Item().first != hash)
+				i = Next(i);
+			return i;
+		}
+		static Bucket* Allocate(BucketAlloc& alloc, size_t capacity)
+		{
+			auto buckets = std::allocator_traits<BucketAlloc>::allocate(alloc, capacity);
+			for (size_t i = 0; i < capacity; ++i)
+				buckets[i].used = false;
+			return buckets;
+		}
+		// fills the unused bucket to with the item of from, which is left unused
+		static void Move(Bucket& to, Bucket& from)
+		{
+			new (&to.storage) value_type(std::move(from.Item()));
+			to.used = true;
+			from.Item().~value_type();
+			from.used = false;
+		}
+		void Construct(Bucket& bucket, uint64_t hash, std::true_type)
+		{
+			new (&bucket.storage) value_type(std::piecewise_construct, std::forward_as_tuple(hash), std::forward_as_tuple(alloc_));
+		}
+		void Construct(Bucket& bucket, uint64_t hash, std::false_type)
+		{
+			new (&bucket.storage) value_type(std::piecewise_construct, std::forward_as_tuple(hash), std::forward_as_tuple());
+		}
+		void Grow() { Rehash(capacity_ ? capacity_ * 2 : 16); }
+		void Rehash(size_t capacity)
+		{
+			auto old = buckets_;
+			auto old_capacity = capacity_;
+			capacity_ = capacity;
+			buckets_ = Allocate(alloc_, capacity_);
+			for (size_t i = 0; i < old_capacity; ++i)
+			{
+				if (old[i].used)
+					Move(buckets_[Probe(old[i].Item().first)], old[i]);
+			}
+			if (old)
+				std::allocator_traits<BucketAlloc>::deallocate(alloc_, old, old_capacity);
+		}
+	public:
+		explicit FlatHashMap(const Alloc& alloc = Alloc()) : alloc_(alloc) {}
+		FlatHashMap(const FlatHashMap&) = delete;
+		FlatHashMap& operator=(const FlatHashMap&) = delete;
+		~FlatHashMap() { Clear(); }
+
+		class iterator
+		{
+			Bucket* it_;
+			Bucket* end_;
+			void Skip() { while (it_ != end_ && !it_->used) ++it_; }
+		public:
+			iterator(Bucket* it, Bucket* end) : it_(it), end_(end) { Skip(); }
+			value_type& operator*() const { return it_->Item(); }
+			value_type* operator->() const { return &it_->Item(); }
+			iterator& operator++() { ++it_; Skip(); return *this; }
+			bool operator!=(const iterator& other) const { return it_ != other.it_; }
+		};
+		iterator begin() { return iterator(buckets_, buckets_ + capacity_); }
+		iterator end() { return iterator(buckets_ + capacity_, buckets_ + capacity_); }
+
+		// room for n items without growing, in one rehash
+		void Reserve(size_t n)
+		{
+			size_t capacity = 16;
+			while (n * 2 > capacity)
+				capacity *= 2;
+			if (capacity > capacity_)
+				Rehash(capacity);
+		}
+		T* Find(uint64_t hash)
+		{
+			if (0 == size_)
+				return nullptr;
+			auto&& bucket = buckets_[Probe(hash)];
+			return bucket.used ? &bucket.Item().second : nullptr;
+		}
+		// inserts a default constructed T, given our allocator if it takes one, when hash is not there yet.
+		// invalidates pointers into the table
+		T& operator[](uint64_t hash)
+		{
+			if ((size_ + 1) * 2 > capacity_)
+				Grow();
+			auto&& bucket = buckets_[Probe(hash)];
+			if (!bucket.used)
+			{
+				Construct(bucket, hash, std::is_constructible<T, const BucketAlloc&>());
+				bucket.used = true;
+				++size_;
+			}
+			return bucket.Item().second;
+		}
+		bool Erase(uint64_t hash)
+		{
+			if (0 == size_)
+				return false;
+			auto hole = Probe(hash);
+			if (!buckets_[hole].used)
+				return false;
+
+			buckets_[hole].Item().~value_type();
+			buckets_[hole].used = false;
+			// pull back the following entries which would not be found any more across the hole
+			for (auto i = Next(hole); buckets_[i].used; i = Next(i))
+			{
+				auto home = Home(buckets_[i].Item().first);
+				bool movable = (hole <= i) ? (home <= hole || home > i) : (home <= hole && home > i);
+				if (movable)
+				{
+					Move(buckets_[hole], buckets_[i]);
+					hole = i;
+				}
+			}
+			--size_;
+			return true;
+		}
+		void Clear()
+		{
+			for (size_t i = 0; i < capacity_; ++i)
+			{
+				if (buckets_[i].used)
+					buckets_[i].Item().~value_type();
+			}
+			if (buckets_)
+				std::allocator_traits<BucketAlloc>::deallocate(alloc_, buckets_, capacity_);
+			buckets_ = nullptr;
+			capacity_ = 0;
+			size_ = 0;
+		}
+		size_t Size() const { return size_; }
+		// the bytes of the array, not counting what the values allocate
+		size_t MemoryUsage() const { return capacity_ * sizeof(Bucket); }
+	};
+
+	// Threading : a mutex type, MultiThreaded<Mutex> or SingleThreaded, the signals of the hub use it too
+	template<typename Threading = std::recursive_mutex, typename Policy = DefaultPolicy>
+	class SignalHub
+	{
+		typedef typename ThreadingOf<Threading>::type ThreadingModel;
+		typedef typename ThreadingModel::Access Access;
+		typedef BasicObjectBase<Access> ObjectBaseType;
+		typedef BasicSignalBase<Access> SignalBaseType;
+		typedef BasicConnectionBase<Access> ConnectionBaseType;
+		typedef std::pair<ObjectBaseType*, typename Access::template WeakPtr<SignalBaseType>> WeakSignal;
+		typedef typename Access::template WeakPtr<ConnectionBaseType> WeakConnection;
+	public:
+		typedef typename Policy::template Allocator<char> AllocatorType;
+	private:
+		// told by a signal added to this hub when it goes away
+		class SignalOwner :
+			public BasicOwnerBase<Access>
+		{
+			SignalHub& hub_;
+		public:
+			SignalOwner(SignalHub& hub) : hub_(hub) {}
+			void Detach(ObjectBaseType* p, SlotKey) override
+			{
+				auto hash = SignalId(static_cast<SignalBaseType*>(p)->Name()).Hash();
+				auto&& shard = hub_.ShardOf(hash);
+				std::lock_guard<decltype(shard.lock_)> l(shard.lock_);
+				auto item = shard.signals_.Find(hash);
+				if (nullptr != item)
+				{
+					if (p == item->first)
+					{
+						// we are the last one
+						shard.signals_.Erase(hash);
+						shard.version_.fetch_add(1, std::memory_order_release);
+					}
+				}
+			}
+		};
+		// told by a connection still waiting for its signal when it goes away
+		class EarlyConnectionOwner :
+			public BasicOwnerBase<Access>
+		{
+			SignalHub& hub_;
+		public:
+			EarlyConnectionOwner(SignalHub& hub) : hub_(hub) {}
+			void Detach(ObjectBaseType* p, SlotKey key) override
+			{
+				auto hash = SignalId(static_cast<ConnectionBaseType*>(p)->SigName()).Hash();
+				auto&& shard = hub_.ShardOf(hash);
+				std::lock_guard<decltype(shard.lock_)> l(shard.lock_);
+				auto conns = shard.early_conns_.Find(hash);
+				if (nullptr != conns)
+				{
+					conns->Erase(key);
+					if (0 == conns->Size())
+						shard.early_conns_.Erase(hash);
+				}
+			}
+		};
+		// the subscription of ConnectPattern, bound to each matching signal through a connection of its own
+		class PatternBase :
+			public ConnectionBaseType
+		{
+		public:
+			// connect to signal if it has our Signature, called with the hub's patterns_lock_ held
+			virtual void Bind(SignalBaseType& signal) = 0;
+		};
+		typedef typename Access::template SharedPtr<PatternBase> PatternPtr;
+		// the patterns by their parts, "*" and "#" parts are children like any other
+		struct PatternNode
+		{
+			std::map<std::string, std::unique_ptr<PatternNode>> children_;
+			SlotMap<typename Access::template WeakPtr<PatternBase>> patterns_;
+		};
+		// told by a subscription of ConnectPattern when it goes away
+		class PatternOwner :
+			public BasicOwnerBase<Access>
+		{
+			SignalHub& hub_;
+		public:
+			PatternOwner(SignalHub& hub) : hub_(hub) {}
+			void Detach(ObjectBaseType* p, SlotKey key) override
+			{
+				std::lock_guard<decltype(hub_.patterns_lock_)> l(hub_.patterns_lock_);
+				auto node = &hub_.patterns_;
+				for (auto&& part : Split(static_cast<ConnectionBaseType*>(p)->SigName()))
+				{
+					auto child = node->children_.find(part);
+					if (node->children_.end() == child)
+						return;
+					node = child->second.get();
+				}
+				node->patterns_.Erase(key);
+			}
+		};
+		// the connections waiting for the signal of one name, made by FlatHashMap with the allocator of the hub
+		struct EarlyConnections :
+			SlotMap<WeakConnection, typename std::allocator_traits<AllocatorType>::template rebind_alloc<WeakConnection>>
+		{
+			typedef std::basic_string<char, std::char_traits<char>, typename std::allocator_traits<AllocatorType>::template rebind_alloc<char>> Name;
+			Name sig_name_;// set by the first connection, the others must have the same
+
+			explicit EarlyConnections(const AllocatorType& alloc) :
+				SlotMap<WeakConnection, typename std::allocator_traits<AllocatorType>::template rebind_alloc<WeakConnection>>(alloc),
+				sig_name_(alloc)
+			{}
+		};
+		/*
+		a stripe of the hub, the signals whose names hash to it and the connections waiting for them, both by the hash of the name.
+		a hash belongs to the first name which takes it, with a signal or connections; another name with the same hash is refused
+		*/
+		struct Shard
+		{
+			typename ThreadingModel::Lock lock_;
+			FlatHashMap<WeakSignal, AllocatorType> signals_;
+			FlatHashMap<EarlyConnections, AllocatorType> early_conns_;
+			typename Access::template Atomic<uint64_t> version_{ 0 };// bumped whenever signals_ changes, lets an Emitter know its cache is stale
+			char pad_[64];// keep the locks of neighbouring shards off each other's cache line
+
+			Shard(const AllocatorType& alloc) : signals_(alloc), early_conns_(alloc) {}
+		};
+		static_assert(Policy::HubShards > 0, "a SignalHub needs at least one shard");
+		AllocatorType alloc_;
+		Shard shards_[Policy::HubShards];
+		SignalOwner signal_owner_;
+		EarlyConnectionOwner early_owner_;
+		typename ThreadingModel::Lock patterns_lock_;// taken after the lock of a shard, never before
+		PatternNode patterns_;
+		PatternOwner pattern_owner_;
+		// the signals at the time of Freeze(), an open addressing table which is never written once published
+		struct FrozenTable
+		{
+			struct Entry
+			{
+				bool used;
+				uint64_t hash;
+				typename Access::template WeakPtr<SignalBaseType> signal;
+			};
+			std::vector<Entry, typename std::allocator_traits<AllocatorType>::template rebind_alloc<Entry>> entries_;// a power of 2 of them
+
+			FrozenTable(size_t capacity, const AllocatorType& alloc) : entries_(capacity, Entry{ false, 0, {} }, alloc) {}
+			size_t Home(uint64_t hash) const
+			{
+				hash ^= hash >> 32;
+				return static_cast<size_t>((hash * 0x9E3779B97F4A7C15ULL) >> 32) & (entries_.size() - 1);
+			}
+			// the entry of hash, or the unused one where it would go
+			Entry& Probe(uint64_t hash)
+			{
+				auto i = Home(hash);
+				while (entries_[i].used && entries_[i].hash != hash)
+					i = (i + 1) & (entries_.size() - 1);
+				return entries_[i];
+			}
+		};
+		typename Access::template Atomic<FrozenTable*> frozen_{ nullptr };// set once by Freeze, owned by the hub
+
+		// the low bits of the hash pick the bucket inside a shard, so take the high ones here
+		Shard& ShardOf(uint64_t hash) { return shards_[(hash >> 32) % Policy::HubShards]; }
+		// the name of an entry of signals_, must be called with the lock of its shard held: the name outlives the entry, which the
+		// destructor of the signal erases under that lock
+		static const std::string& NameOf(const WeakSignal& item) { return static_cast<SignalBaseType*>(item.first)->Name(); }
+		// the signal of sig_name, from the table of Freeze() without a lock when it is there
+		typename Access::template SharedPtr<SignalBaseType> FindSignal(const SignalId& sig_name)
+		{
+			auto frozen = frozen_.load(std::memory_order_acquire);
+			if (nullptr != frozen)
+			{
+				auto signal = frozen->Probe(sig_name.Hash()).signal.lock();
+				if (signal && sig_name.Is(signal->Name()))
+					return signal;
+			}
+			auto&& shard = ShardOf(sig_name.Hash());
+			std::lock_guard<decltype(shard.lock_)> l(shard.lock_);
+			auto item = shard.signals_.Find(sig_name.Hash());
+			if (nullptr == item || !sig_name.Is(NameOf(*item)))
+				return nullptr;
+			return item->second.lock();
+		}
+		// whether a live signal or waiting connections of another name have hash, must be called with the lock of shard held
+		static bool Taken(Shard& shard, uint64_t hash, const SignalId& sig_name)
+		{
+			auto item = shard.signals_.Find(hash);
+			if (nullptr != item && !item->second.expired() && !sig_name.Is(NameOf(*item)))
+				return true;
+			auto conns = shard.early_conns_.Find(hash);
+			return nullptr != conns && conns->Size() > 0 && !sig_name.Is(conns->sig_name_);
+		}
+		static std::vector<std::string> Split(const std::string& name)
+		{
+			std::vector<std::string> parts;
+			size_t begin = 0;
+			for (;;)
+			{
+				auto end = name.find('.', begin);
+				parts.push_back(name.substr(begin, std::string::npos == end ? std::string::npos : end - begin));
+				if (std::string::npos == end)
+					return parts;
+				begin = end + 1;
+			}
+		}
+		// whether the parts [i, end) of a pattern match the parts [j, end) of a name
+		static bool Matches(const std::vector<std::string>& pattern, size_t i, const std::vector<std::string>& name, size_t j)
+		{
+			if (pattern.size() == i)
+				return name.size() == j;
+			if ("#" == pattern[i])
+			{
+				for (auto k = j; k <= name.size(); ++k)
+				{
+					if (Matches(pattern, i + 1, name, k))
+						return true;
+				}
+				return false;
+			}
+			return j < name.size() && ("*" == pattern[i] || pattern[i] == name[j]) && Matches(pattern, i + 1, name, j + 1);
+		}
+		// collects the live patterns under node which match the parts [i, end) of a name, must be called with patterns_lock_ held
+		static void Match(PatternNode& node, const std::vector<std::string>& name, size_t i, std::vector<PatternPtr>& matches)
+		{
+			if (name.size() == i)
+			{
+				for (auto&& item : node.patterns_)
+				{
+					auto pattern = item.lock();
+					if (pattern)
+						matches.push_back(pattern);
+				}
+			}
+			else
+			{
+				auto child = node.children_.find(name[i]);
+				if (node.children_.end() != child)
+					Match(*child->second, name, i + 1, matches);
+				child = node.children_.find("*");
+				if (node.children_.end() != child)
+					Match(*child->second, name, i + 1, matches);
+			}
+			auto child = node.children_.find("#");
+			if (node.children_.end() != child)
+			{
+				for (auto k = i; k <= name.size(); ++k)
+					Match(*child->second, name, k, matches);
+			}
+		}
+		static void Finalize(PatternNode& node)
+		{
+			for (auto&& item : node.patterns_)
+			{
+				auto pattern = item.lock();
+				if (pattern)
+					pattern->OnFinal();
+			}
+			node.patterns_.Clear();
+			for (auto&& child : node.children_)
+				Finalize(*child.second);
+		}
+		// connect the patterns matching the name of a signal being added, must be called with the lock of its shard held
+		// publishes signal, with the lock of shard held; false when another name has the hash
+		template<typename SignalPtrType>
+		bool Register(Shard& shard, uint64_t hash, const SignalPtrType& signal)
+		{
+			typedef typename SignalPtrType::element_type SignalImpl;
+			if (Taken(shard, hash, signal->name_))
+				return false;
+			// the early connections are bound and the signal published under one lock, a Connect either sees the signal or lands
+			// in early_conns_ before we read it
+			auto conns = shard.early_conns_.Find(hash);
+			if (nullptr != conns)
+			{
+				std::vector<typename SignalImpl::ConnectionPtr> bound;
+				bound.reserve(conns->Size());
+				for (auto&& conn : *conns)
+				{
+					auto tmp = conn.lock();
+					if (nullptr == tmp)
+						continue;
+					auto typed = Access::template DynamicCast<typename SignalImpl::ConnectionType>(tmp);
+					if (nullptr != typed)
+						bound.push_back(std::move(typed));
+					else
+						tmp->OnFinal();// of another Signature: never bound, and its key must not reach the next list of this name
+				}
+				shard.early_conns_.Erase(hash);
+				signal->ConnectInternal(bound.data(), bound.data() + bound.size());
+			}
+			// and so are the patterns it matches, ConnectPattern holds the lock of every shard while it looks at their signals
+			BindPatterns(*signal);
+
+			signal->owner_ = &signal_owner_;
+			shard.signals_[hash] = std::make_pair(signal.get(), signal);
+			return true;
+		}
+		// the indexes of hashes grouped by shard, and by hash within a shard, so bulk calls lock each shard once
+		struct ShardRun
+		{
+			Shard* shard;
+			std::vector<size_t> indexes;
+		};
+		std::vector<ShardRun> ByShard(const std::vector<uint64_t>& hashes)
+		{
+			std::vector<size_t> order(hashes.size());
+			for (size_t i = 0; i < order.size(); ++i)
+				order[i] = i;
+			std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+			{
+				auto shard_a = &ShardOf(hashes[a]);
+				auto shard_b = &ShardOf(hashes[b]);
+				return shard_a != shard_b ? shard_a < shard_b : (hashes[a] != hashes[b] ? hashes[a] < hashes[b] : a < b);
+			});
+			std::vector<ShardRun> result;
+			for (auto i : order)
+			{
+				if (result.empty() || result.back().shard != &ShardOf(hashes[i]))
+					result.push_back(ShardRun{ &ShardOf(hashes[i]), std::vector<size_t>() });
+				result.back().indexes.push_back(i);
+			}
+			return result;
+		}
+		void BindPatterns(SignalBaseType& signal)
+		{
+			std::vector<PatternPtr> matches;// released once patterns_lock_ is, the last reference detaches
+			std::lock_guard<decltype(patterns_lock_)> l(patterns_lock_);
+			if (patterns_.children_.empty())
+				return;
+			Match(patterns_, Split(signal.Name()), 0, matches);
+			// "#.#" and the like reach a pattern more than once
+			std::sort(matches.begin(), matches.end(), [](const PatternPtr& a, const PatternPtr& b) { return a.get() < b.get(); });
+			matches.erase(std::unique(matches.begin(), matches.end(), [](const PatternPtr& a, const PatternPtr& b) { return a.get() == b.get(); }), matches.end());
+			for (auto&& pattern : matches)
+				pattern->Bind(signal);
+		}
+	public:
+		template<typename Signature>
+		using SignalType = Signal<Signature, Threading, Policy>;
+		template<typename Signature>
+		using ConnectionType = typename SignalType<Signature>::ConnectionType;
+		// std::shared_ptr unless SingleThreaded
+		template<typename Signature>
+		using SignalPtr = typename Access::template SharedPtr<SignalType<Signature>>;
+		template<typename Signature>
+		using ConnectionPtr = typename Access::template SharedPtr<ConnectionType<Signature>>;
+
+		/*
+		made by ConnectPattern, keep it as long as you want the slot connected to the matching signals.
+		SigName() is the pattern, Enable() switches the connections to all of them
+		*/
+		template<typename Signature>
+		class Subscription :
+			public PatternBase
+		{
+			friend class SignalHub;
+			typename SignalType<Signature>::SlotType slot_;
+			Executor* executor_ = nullptr;
+			int group_ = 0;
+			BasicEnableGate<Access>* switch_ = new BasicEnableGate<Access>;// joined by each of conns_
+			std::vector<ConnectionPtr<Signature>> conns_;// guarded by the hub's patterns_lock_
+			size_t prune_at_ = 16;// conns_ is swept for the ones of removed signals when it reaches this size
+
+			void Bind(SignalBaseType& signal) override
+			{
+				auto typed = dynamic_cast<SignalType<Signature>*>(&signal);
+				if (nullptr == typed)
+					return;// a signal of another Signature
+				if (conns_.size() >= prune_at_)
+				{
+					conns_.erase(std::remove_if(conns_.begin(), conns_.end(), [](const ConnectionPtr<Signature>& conn) { return conn->Orphaned(); }), conns_.end());
+					prune_at_ = std::max<size_t>(16, conns_.size() * 2);
+				}
+				auto conn = typed->MakeConnection(slot_, group_, this->name_, executor_);
+				conn->Join(switch_);
+				typed->ConnectInternal(conn);
+				conns_.push_back(std::move(conn));
+			}
+		public:
+			~Subscription(){ switch_->Release(); }
+			void Enable(bool enable = true) override
+			{
+				PatternBase::Enable(enable);
+				switch_->Enable(enable);
+			}
+		};
+		template<typename Signature>
+		using SubscriptionPtr = typename Access::template SharedPtr<Subscription<Signature>>;
+
+		/*
+		a typed handle to a signal of this hub, made by Resolve()
+		it caches the signal, so an emit costs a weak_ptr::lock() instead of the hub lock, a lookup and a dynamic_pointer_cast,
+		and resolves the name again only when a signal has been added or removed since.
+		an Emitter must not outlive its hub, and a single instance must not be used by several threads at once
+		*/
+		template<typename Signature>
+		class Emitter
+		{
+			friend class SignalHub;
+			SignalHub* hub_;
+			uint64_t hash_;
+			std::string name_;
+			uint64_t version_;
+			typename Access::template WeakPtr<SignalType<Signature>> signal_;
+
+			Emitter(SignalHub* hub, const SignalId& sig_name) : hub_(hub), hash_(sig_name.Hash()), name_(sig_name.Name()), version_(0) {}
+			void Refresh()
+			{
+				if (hub_->ShardOf(hash_).version_.load(std::memory_order_acquire) != version_)
+					hub_->Resolve(*this);
+			}
+		public:
+			// without a signal the result is the one of an emission to no slot
+			template <typename ...Params>
+			auto operator()(Params&&... params) -> typename SignalType<Signature>::ResultType
+			{
+				Refresh();
+				auto signal = signal_.lock();
+				if (signal)
+					return (*signal)(std::forward<Params>(params)...);
+				return typename SignalType<Signature>::CombinerType().Result();
+			}
+			template <typename ...Params>
+			auto Emit(Params&&... params) -> typename SignalType<Signature>::ResultType
+			{
+				return operator()(std::forward<Params>(params)...);
+			}
+			// nullptr while the hub has no signal of this name
+			SignalPtr<Signature> Get()
+			{
+				Refresh();
+				return signal_.lock();
+			}
+		};
+
+		SignalHub() : SignalHub(AllocatorType()) {}
+		// alloc : where the hub's tables, its signals and their connections get their memory
+		explicit SignalHub(const AllocatorType& alloc) : SignalHub(alloc, typename MakeIndexSequence<Policy::HubShards>::type()) {}
+		~SignalHub()
+		{
+			auto frozen = frozen_.load(std::memory_order_acquire);
+			if (frozen)
+			{
+				frozen->~FrozenTable();
+				typename std::allocator_traits<AllocatorType>::template rebind_alloc<FrozenTable> alloc(alloc_);
+				std::allocator_traits<decltype(alloc)>::deallocate(alloc, frozen, 1);
+			}
+			{
+				std::lock_guard<decltype(patterns_lock_)> l(patterns_lock_);
+				Finalize(patterns_);
+			}
+			for (auto&& shard : shards_)
+			{
+				std::lock_guard<decltype(shard.lock_)> l(shard.lock_);
+				for (auto&& iter : shard.signals_)
+				{
+					auto&& item = iter.second;
+					auto locked_item = item.second.lock();
+					if (locked_item)
+					{
+						locked_item->OnFinal();
+					}
+				}
+				shard.signals_.Clear();
+				for (auto&& iter : shard.early_conns_)
+				{
+					auto&& conns = iter.second;
+					for (auto&& item : conns)
+					{
+						auto locked_item = item.lock();
+						if (locked_item)
+						{
+							locked_item->OnFinal();
+						}
+					}
+				}
+				shard.early_conns_.Clear();
+			}
+		}
+
+		/*
+		save the return value to keep the signal valid
+		sig_name : required, unique, used to bind sig-slot, a string or a SignalId.
+		returns nullptr when a signal or connections of another name with the same hash are there
+		*/
+		template<typename Signature>
+		auto AddSignal(SignalId sig_name) -> SignalPtr<Signature>
+		{
+			// the signal and its control block share one allocation, unregistering is done by ~BasicSignalBase
+			auto result = Access::template AllocateShared<SignalType<Signature>>(alloc_, alloc_);
+			result->name_ = sig_name.Name();
+
+			auto&& shard = ShardOf(sig_name.Hash());
+			std::lock_guard<decltype(shard.lock_)> l(shard.lock_);
+			if (!Register(shard, sig_name.Hash(), result))
+				return nullptr;
+			shard.version_.fetch_add(1, std::memory_order_release);
+			return result;
+		}
+		/*
+		AddSignal for each name in [first, last), whose elements convert to SignalId; the signals are returned in the same order,
+		nullptr for a name refused as by AddSignal. they are all made before any lock is taken, then each shard is locked once
+		*/
+		template<typename Signature, typename Iterator>
+		auto AddSignals(Iterator first, Iterator last) -> std::vector<SignalPtr<Signature>>
+		{
+			std::vector<SignalPtr<Signature>> result;
+			std::vector<uint64_t> hashes;
+			for (auto it = first; it != last; ++it)
+			{
+				SignalId sig_name(*it);
+				auto signal = Access::template AllocateShared<SignalType<Signature>>(alloc_, alloc_);
+				signal->name_ = sig_name.Name();
+				hashes.push_back(sig_name.Hash());
+				result.push_back(std::move(signal));
+			}
+
+			for (auto&& run : ByShard(hashes))
 			{
-				auto locked_conn = conn.second.lock();
-				if (locked_conn)
-				{// clear the callback
-					locked_conn->OnFinal();
+				auto&& shard = *run.shard;
+				std::lock_guard<decltype(shard.lock_)> l(shard.lock_);
+				shard.signals_.Reserve(shard.signals_.Size() + run.indexes.size());
+				for (auto i : run.indexes)
+				{
+					if (!Register(shard, hashes[i], result[i]))
+						result[i] = SignalPtr<Signature>();// never registered, it goes away without calling us
 				}
+				shard.version_.fetch_add(1, std::memory_order_release);
 			}
+			return result;
 		}
-		template <typename ...Params>
-		void operator()(Params&&... params)
-		{
-			if (!Enabled())
-				return;
 
-			std::lock_guard<decltype(lock_)> l(lock_);
-			auto it = conns_.begin();
-			auto itEnd = conns_.end();
+		/*
+		look sig_name up once and keep emitting through the returned handle
+		the signal doesn't need to exist yet, the handle picks it up once it is added
+		*/
+		template<typename Signature>
+		auto Resolve(SignalId sig_name) -> Emitter<Signature>
+		{
+			Emitter<Signature> result(this, sig_name);
+			Resolve(result);
+			return result;
+		}
 
-			while (it != itEnd)
+		/*
+		save the return value as long as you want to keep the connection
+		sig_name : required, unique, used to bind sig-slot, a string or a SignalId
+		slot_name : optional, for debug purpose
+		executor : optional, the slot is posted to it instead of being called on the emitting thread
+		returns nullptr when a signal or connections of another name with the same hash are there
+		*/
+		template<typename Signature>
+		auto Connect(SignalId sig_name, typename SignalType<Signature>::SlotType func, std::string slot_name = "", Executor* executor = nullptr) -> ConnectionPtr<Signature>
+		{
+			return Connect<Signature>(sig_name, std::move(func), 0, std::move(slot_name), executor);
+		}
+		// group : the slots of lower groups are called first, see Signal::Connect
+		template<typename Signature>
+		auto Connect(SignalId sig_name, typename SignalType<Signature>::SlotType func, int group, std::string slot_name = "", Executor* executor = nullptr) -> ConnectionPtr<Signature>
+		{
+			auto&& shard = ShardOf(sig_name.Hash());
+			std::lock_guard<decltype(shard.lock_)> l(shard.lock_);
+			if (Taken(shard, sig_name.Hash(), sig_name))
+				return nullptr;
+			auto item = shard.signals_.Find(sig_name.Hash());
+			if (nullptr != item)
 			{
-				auto itNext = it;
-				++itNext;
-
-				auto conn = it->second.lock();
-				if (conn)
-					(*conn)(params...);
-				else
-					conns_.erase(it);
-
-				it = itNext;
+				auto signal = item->second.lock();
+				if (nullptr != signal)
+					return Access::template DynamicCast<SignalType<Signature>>(signal)->Connect(std::move(func), group, slot_name, executor);
 			}
+
+			// the signal is not available now, store to a weak_ptr first
+			auto result = Access::template AllocateShared<ConnectionType<Signature>>(alloc_);
+			result->slot_ = std::move(func);
+			result->executor_ = executor;
+			result->group_ = group;
+			result->name_ = slot_name;
+			result->sig_name_ = sig_name.Name();
+			auto&& early = shard.early_conns_[sig_name.Hash()];
+			early.sig_name_.assign(result->sig_name_.data(), result->sig_name_.size());
+			result->key_ = early.Insert(result);
+			result->owner_ = &early_owner_;
+			return result;
 		}
-		template <typename ...Params>
-		void Emit(Params&&... params)
+		// an element of ConnectMany, the arguments of one Connect
+		template<typename Signature>
+		struct ConnectRequest
 		{
-			operator()(params...);
-		}
-		// save the return value as long as you want to keep the connection
-		auto Connect(std::function<Signature> func, std::string name = "") -> std::shared_ptr<Connection<Signature>>
+			SignalId sig_name;
+			typename SignalType<Signature>::SlotType func;
+			int group;
+			std::string slot_name;
+			Executor* executor;
+
+			ConnectRequest(SignalId sig_name, typename SignalType<Signature>::SlotType func, int group = 0, std::string slot_name = "", Executor* executor = nullptr) :
+				sig_name(sig_name), func(std::move(func)), group(group), slot_name(std::move(slot_name)), executor(executor)
+			{}
+		};
+		/*
+		Connect for each ConnectRequest<Signature> in [first, last), the connections are returned in the same order, nullptr for
+		those refused as by Connect. they are all made before any lock is taken, then each shard is locked once and each signal takes its connections at once,
+		publishing its slot list a single time. pass std::make_move_iterator to move the slots out of the requests
+		*/
+		template<typename Signature, typename Iterator>
+		auto ConnectMany(Iterator first, Iterator last) -> std::vector<ConnectionPtr<Signature>>
 		{
-			auto conn = new Connection<Signature>();
-			conn->slot_ = func;
-			conn->name_ = name;
-			conn->sig_name_ = name_;
+			std::vector<ConnectionPtr<Signature>> result;
+			std::vector<uint64_t> hashes;
+			for (auto it = first; it != last; ++it)
+			{
+				auto&& request = *it;
+				auto conn = Access::template AllocateShared<ConnectionType<Signature>>(alloc_);
+				conn->slot_ = std::forward<decltype(request)>(request).func;
+				conn->executor_ = request.executor;
+				conn->group_ = request.group;
+				conn->name_ = std::forward<decltype(request)>(request).slot_name;
+				conn->sig_name_ = request.sig_name.Name();
+				hashes.push_back(request.sig_name.Hash());
+				result.push_back(std::move(conn));
+			}
 
-			auto result = std::shared_ptr<Connection<Signature>>(conn, [](Connection<Signature>* p)
+			std::vector<ConnectionPtr<Signature>> batch;
+			for (auto&& run : ByShard(hashes))
 			{
-				if (p->deleter_)
-					p->deleter_(p);
-				delete p;
-			});
-			ConnectInternal(conn,result);
+				auto&& shard = *run.shard;
+				std::lock_guard<decltype(shard.lock_)> l(shard.lock_);
+				for (size_t begin = 0, end = 0; begin < run.indexes.size(); begin = end)
+				{
+					auto hash = hashes[run.indexes[begin]];
+					for (end = begin; end < run.indexes.size() && hashes[run.indexes[end]] == hash; ++end)
+						;
+					auto item = shard.signals_.Find(hash);
+					auto signal = nullptr != item ? item->second.lock() : nullptr;
+					auto early = shard.early_conns_.Find(hash);
+					// the run may hold several names of this hash, only the one which has it or else the first is connected
+					std::string name = result[run.indexes[begin]]->sig_name_;
+					if (nullptr != signal)
+						name = signal->Name();
+					else if (nullptr != early && early->Size() > 0)
+						name.assign(early->sig_name_.data(), early->sig_name_.size());
+					batch.clear();
+					for (auto i = begin; i < end; ++i)
+					{
+						auto&& conn = result[run.indexes[i]];
+						if (conn->sig_name_ == name)
+							batch.push_back(conn);
+						else
+							conn = ConnectionPtr<Signature>();// never connected, it goes away without calling us
+					}
+					if (nullptr != signal)
+					{
+						Access::template DynamicCast<SignalType<Signature>>(signal)->ConnectInternal(batch.data(), batch.data() + batch.size());
+						continue;
+					}
+					// the signal is not available now, as in Connect
+					auto&& waiting = shard.early_conns_[hash];
+					waiting.sig_name_.assign(name.data(), name.size());
+					waiting.Reserve(waiting.Size() + batch.size());
+					for (auto&& conn : batch)
+					{
+						conn->key_ = waiting.Insert(conn);
+						conn->owner_ = &early_owner_;
+					}
+				}
+			}
 			return result;
 		}
-		// this is not required, you can reset conn to disconnect
-// 		void Disconnect(std::shared_ptr<Connection<Signature>> conn)
-// 		{
-// 			std::lock_guard<decltype(lock_)> l(lock_);
-// 			auto iter = std::find_if(conns_.begin(), conns_.end(), [&conn](std::weak_ptr<Connection<Signature>> l){
-// 				auto lconn = l.lock();
-// 				return (lconn == conn);
-// 			});
-// 			if (conns_.end() != iter)
-// 				conns_.erase(iter);
-// 		}
-// 		void DisconnectAll()
-// 		{
-// 			std::lock_guard<decltype(lock_)> l(lock_);
-// 			conns_.clear();
-// 		}
-	protected:
-		void ConnectInternal(void* p, std::shared_ptr<Connection<Signature>> conn)
+
+		/*
+		connect func to every signal whose name matches pattern, the ones added later included; save the return value as long
+		as you want to keep the connections. names are split at the dots, a "*" part matches any one part and a "#" part any
+		number of them, "md.eq.*" receives "md.eq.ibm" and "md.#" receives "md", "md.eq" and "md.eq.ibm".
+		a signal is matched once, when it is added, emitting it is the same whether its slots came from patterns or not.
+		the signals with another Signature are skipped
+		*/
+		template<typename Signature>
+		auto ConnectPattern(const std::string& pattern, typename SignalType<Signature>::SlotType func, std::string slot_name = "", Executor* executor = nullptr) -> SubscriptionPtr<Signature>
 		{
-			std::lock_guard<decltype(lock_)> l(lock_);
-			conns_.push_back(std::make_pair(p,conn));
+			return ConnectPattern<Signature>(pattern, std::move(func), 0, std::move(slot_name), executor);
+		}
+		template<typename Signature>
+		auto ConnectPattern(const std::string& pattern, typename SignalType<Signature>::SlotType func, int group, std::string slot_name = "", Executor* executor = nullptr) -> SubscriptionPtr<Signature>
+		{
+			auto result = Access::template AllocateShared<Subscription<Signature>>(alloc_);
+			result->slot_ = std::move(func);
+			result->executor_ = executor;
+			result->group_ = group;
+			result->name_ = std::move(slot_name);
+			result->sig_name_ = pattern;
+			auto parts = Split(pattern);
 
-			// replace the deleter
-			auto name = conn->Name();
-			conn->deleter_ = [this, name](void* p)
+			// no signal can be added while we hold the lock of every shard, so each is either seen here or binds us in AddSignal
+			std::vector<typename Access::template SharedPtr<SignalBaseType>> signals;// released after the locks, the last reference detaches
+			std::vector<std::unique_lock<typename ThreadingModel::Lock>> locks;
+			for (auto&& shard : shards_)
+				locks.emplace_back(shard.lock_);
+			std::lock_guard<decltype(patterns_lock_)> l(patterns_lock_);
+			auto node = &patterns_;
+			for (auto&& part : parts)
 			{
-				std::lock_guard<decltype(lock_)> l(lock_);
-				auto conn_iter = std::find_if(conns_.begin(), conns_.end(), [p](WeakConnection iter) -> bool
-				{
-					return iter.first == p;
-				});
-				if (conn_iter != conns_.end())
-					conns_.erase(conn_iter);
-#if defined(_DEBUG) || defined(DEBUG)
-				if (name.size())
-				{
-					named_conns_.erase(name);
-				}
-#endif
-			};
+				auto&& child = node->children_[part];
+				if (!child)
+					child.reset(new PatternNode);
+				node = child.get();
+			}
+			result->key_ = node->patterns_.Insert(result);
+			result->owner_ = &pattern_owner_;
 
-#if defined(_DEBUG) || defined(DEBUG)
-			if (name.size())
+			for (auto&& shard : shards_)
 			{
-				auto conn_iter = named_conns_.find(name);
-				if (conn_iter != named_conns_.end())
+				for (auto&& iter : shard.signals_)
 				{
-					auto old_conn = conn_iter->second.second.lock();
-					assert(nullptr == old_conn); // an old instance is still valid
+					auto signal = iter.second.second.lock();
+					if (!signal)
+						continue;
+					if (Matches(parts, 0, Split(signal->Name()), 0))
+						result->Bind(*signal);
+					signals.push_back(std::move(signal));
 				}
-				named_conns_[name] = std::make_pair(p, conn);
 			}
-#endif
+			return result;
 		}
-	};
-	// a utility class to hold all connections/signals
-	template<typename Element, typename Mutex = std::recursive_mutex>
-	class ObjectContainer
-	{
-		Mutex lock_;
-		std::list<std::shared_ptr<Element>> items_;
-	public:
-		void Save(std::shared_ptr<Element> item)
+
+		template <typename Signature, typename ...Params>
+		auto Emit(SignalId sig_name, Params&&... params) -> typename SignalType<Signature>::ResultType
 		{
-			std::lock_guard<decltype(lock_)> l(lock_);
-			items_.push_back(item);
+			auto signal = FindSignal(sig_name);
+			if (nullptr == signal)
+				return typename SignalType<Signature>::CombinerType().Result();
+			return (*Access::template DynamicCast<SignalType<Signature>>(signal))(std::forward<Params>(params)...);
 		}
-		void Enable(bool enable=true)
+#ifdef NAMEDSIGSLOT_COROUTINES
+		// Signal::Next of the signal named sig_name, resumes right away with std::nullopt when there is none
+		template <typename Signature>
+		auto Next(SignalId sig_name, Executor* executor = nullptr) -> typename SignalType<Signature>::NextEmission
 		{
-			std::lock_guard<decltype(lock_)> l(lock_);
-			for (auto&& item : items_)
-				item->Enable(enable);
+			auto signal = Access::template DynamicCast<SignalType<Signature>>(FindSignal(sig_name));
+			auto raw = signal.get();
+			return typename SignalType<Signature>::NextEmission(raw, std::move(signal), executor);
 		}
-		template<typename Comp>
-		void EnableIf(Comp comp, bool enable=true)
+#endif
+		/*
+		the metrics of every signal of the hub and of their slots, keyed by the signal and slot names.
+		all zero unless Policy::Metrics is CollectMetrics
+		*/
+		std::vector<SignalMetrics> Snapshot()
 		{
-			std::lock_guard<decltype(lock_)> l(lock_);
-			for (auto&& item : items_)
+			std::vector<typename Access::template SharedPtr<SignalBaseType>> signals;
+			for (auto&& shard : shards_)
 			{
-				if (comp(item))
+				std::lock_guard<decltype(shard.lock_)> l(shard.lock_);
+				for (auto&& iter : shard.signals_)
 				{
-					item->Enable(enable);
+					auto signal = iter.second.second.lock();
+					if (signal)
+						signals.push_back(signal);
 				}
 			}
+			std::vector<SignalMetrics> result;
+			for (auto&& signal : signals)
+				result.push_back(signal->ReadMetrics());
+			return result;
 		}
-		// use std::shared_ptr, release the object to disconnect all
-// 		void DisconnectAll()
-// 		{
-// 			std::lock_guard<decltype(lock_)> l(lock_);
-// 			items_.clear();
-// 		}
-	};
-
-	template<typename Mutex = std::recursive_mutex>
-	class SignalHub
-	{
-		typedef std::pair<void*, std::weak_ptr<SignalBase>> WeakSignal;
-		typedef std::pair<void*, std::weak_ptr<ConnectionBase>> WeakConnection;
-		Mutex lock_;
-		std::map<std::string, WeakSignal> signals_;
-		std::map<std::string, std::list<WeakConnection>>  early_conns_;
-	public:
-		SignalHub()
-		{}
-		~SignalHub()
+		/*
+		for a hub whose signals are all added at startup: copies them to an immutable table which Emit() and Next() look names up in
+		with one probe and no lock. signals added later are still found, through the lock of their shard as before, but a frozen
+		signal is found first as long as it is alive, even if a signal of the same name was added since.
+		only the first call does something, returns whether it did
+		*/
+		bool Freeze()
 		{
-			std::lock_guard<decltype(lock_)> l(lock_);
-			for (auto&& iter : signals_)
+			if (frozen_.load(std::memory_order_acquire))
+				return false;
+			std::vector<std::pair<uint64_t, typename Access::template WeakPtr<SignalBaseType>>> signals;
+			for (auto&& shard : shards_)
 			{
-				auto&& item = iter.second;
-				auto locked_item = item.second.lock();
-				if (locked_item)
+				std::lock_guard<decltype(shard.lock_)> l(shard.lock_);
+				for (auto&& iter : shard.signals_)
 				{
-					locked_item->OnFinal();
+					if (!iter.second.second.expired())
+						signals.push_back(std::make_pair(iter.first, iter.second.second));
 				}
 			}
-			signals_.clear();
-			for (auto&& iter : early_conns_)
+			size_t capacity = 2;
+			while (capacity < signals.size() * 2)
+				capacity <<= 1;
+
+			typename std::allocator_traits<AllocatorType>::template rebind_alloc<FrozenTable> alloc(alloc_);
+			auto table = new (std::allocator_traits<decltype(alloc)>::allocate(alloc, 1)) FrozenTable(capacity, alloc_);
+			for (auto&& signal : signals)
 			{
-				auto&& conns = iter.second;
-				for (auto&& item : conns)
-				{
-					auto locked_item = item.second.lock();
-					if (locked_item)
-					{
-						locked_item->OnFinal();
-					}
-				}
+				auto&& entry = table->Probe(signal.first);
+				entry.used = true;
+				entry.hash = signal.first;
+				entry.signal = std::move(signal.second);
 			}
-			early_conns_.clear();
+			FrozenTable* expected = nullptr;
+			if (!frozen_.compare_exchange_strong(expected, table, std::memory_order_acq_rel))
+			{// frozen by another thread meanwhile
+				table->~FrozenTable();
+				std::allocator_traits<decltype(alloc)>::deallocate(alloc, table, 1);
+				return false;
+			}
+			return true;
 		}
-
+		bool Frozen() { return nullptr != frozen_.load(std::memory_order_acquire); }
 		/*
-		save the return value to keep the signal valid
-		sig_name : required, unique, used to bind sig-slot
+		about the bytes the hub holds: itself, its tables, the lists of connections waiting for their signal, and the signals
+		with their connections (see Signal::MemoryUsage). the trie of ConnectPattern is not counted
 		*/
+		size_t MemoryUsage()
+		{
+			size_t result = sizeof(*this);
+			auto frozen = frozen_.load(std::memory_order_acquire);
+			if (frozen)
+				result += sizeof(FrozenTable) + frozen->entries_.capacity() * sizeof(typename FrozenTable::Entry);
+			std::vector<typename Access::template SharedPtr<SignalBaseType>> signals;
+			for (auto&& shard : shards_)
+			{
+				std::lock_guard<decltype(shard.lock_)> l(shard.lock_);
+				result += shard.signals_.MemoryUsage() + shard.early_conns_.MemoryUsage();
+				for (auto&& iter : shard.early_conns_)
+					result += iter.second.MemoryUsage();
+				for (auto&& iter : shard.signals_)
+				{
+					auto signal = iter.second.second.lock();
+					if (signal)
+						signals.push_back(signal);
+				}
+			}
+			for (auto&& signal : signals)
+				result += signal->MemoryUsage();
+			return result;
+		}
+	protected:
+		template<size_t ...I>
+		SignalHub(const AllocatorType& alloc, IndexSequence<I...>) :
+			alloc_(alloc),
+			shards_{ { (static_cast<void>(I), alloc) }... },
+			signal_owner_(*this),
+			early_owner_(*this),
+			pattern_owner_(*this)
+		{}
 		template<typename Signature>
-		auto AddSignal(std::string sig_name) -> std::shared_ptr<Signal<Signature,Mutex>>
+		void Resolve(Emitter<Signature>& emitter)
+		{
+			auto&& shard = ShardOf(emitter.hash_);
+			std::lock_guard<decltype(shard.lock_)> l(shard.lock_);
+			emitter.version_ = shard.version_.load(std::memory_order_relaxed);
+			emitter.signal_.reset();
+
+			auto item = shard.signals_.Find(emitter.hash_);
+			if (nullptr == item || NameOf(*item) != emitter.name_)
+				return;
+			emitter.signal_ = Access::template DynamicCast<SignalType<Signature>>(item->second.lock());
+		}
+	};
+
+#ifdef NAMEDSIGSLOT_SHARED_MEMORY
+	/*
+	a hub whose signals live in a POSIX shared memory segment, for processes of one host. a producer adds a signal of a trivially
+	copyable T and emits into its ring: a fetch_add and a copy of the value, no lock and no system call. consumers in any process
+	attached to the segment connect to it by name as with SignalHub, and Poll() calls their slots with the values emitted since.
+	a ring keeps the last capacity values of its signal and never waits for readers: one which falls further behind skips to the
+	oldest value still there, Dropped() counts what it missed. any number of producers may emit to a signal, one which the others
+	lap before it claims its cell drops its value. signals stay until the segment is removed, names are at most 63 characters.
+	a process dying while adding a signal leaves the segment locked for adding, one dying while emitting holds back the producers
+	which come around to its cell
+	*/
+	template<typename Threading = std::recursive_mutex, typename Policy = DefaultPolicy>
+	class SharedSignalHub
+	{
+		static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "shared memory needs address-free atomics");
+		static const uint64_t Magic = 0x3142485367695353ULL;
+		struct Header
+		{
+			std::atomic<uint64_t> magic;// stored last by the process which made the segment
+			uint64_t size;
+			uint64_t capacity;// entries of the signal table, a power of two
+			std::atomic<uint64_t> used;// bytes handed out from the start of the segment
+			std::atomic<uint32_t> lock;// held while adding a signal
+		};
+		struct SignalEntry
 		{
-			auto signal = new Signal<Signature, Mutex>();
-			signal->name_ = sig_name;
+			std::atomic<uint32_t> ready;// set once the entry is filled, entries are never removed
+			uint32_t size;// of the value type
+			uint32_t alignment;
+			uint32_t stride;// bytes of a cell
+			uint64_t hash;
+			uint64_t mask;// cells - 1
+			uint64_t offset;// of the first cell
+			char name[64];
+			alignas(64) std::atomic<uint64_t> head;// cells claimed so far, alone on its cache line with its readers
+		};
+		// a value follows its seq, which is 2 * index + 1 while being written and 2 * index + 2 once it is, and never goes back
+		struct Cell
+		{
+			std::atomic<uint64_t> seq;
+		};
+		static size_t ValueOffset(size_t alignment) { return (sizeof(Cell) + alignment - 1) / alignment * alignment; }
+		static size_t Align(size_t n, size_t alignment) { return (n + alignment - 1) / alignment * alignment; }
+	public:
+		typedef typename ThreadingOf<Threading>::type ThreadingModel;
+		template<typename T>
+		using SignalType = Signal<void(const T&), Threading, Policy>;
+		template<typename T>
+		using ConnectionPtr = typename SignalType<T>::ConnectionPtr;
 
-			auto conns_iter = early_conns_.find(sig_name);
-			if (conns_iter != early_conns_.end())
+		// made by AddSignal, emits without looking the name up; invalid when the signal could not be added
+		template<typename T>
+		class SharedEmitter
+		{
+			friend class SharedSignalHub;
+			SignalEntry* entry_ = nullptr;
+			unsigned char* cells_ = nullptr;
+		public:
+			SharedEmitter() {}
+			explicit operator bool() const { return nullptr != entry_; }
+			void operator()(const T& value) { Emit(value); }
+			void Emit(const T& value)
 			{
-				auto&& conns = conns_iter->second;
-				for (auto&& conn : conns)
+				if (nullptr == entry_)
+					return;
+				auto index = entry_->head.fetch_add(1, std::memory_order_relaxed);
+				auto cell = reinterpret_cast<Cell*>(cells_ + (index & entry_->mask) * entry_->stride);
+				// several producers may reach the cell a lap apart: claim it from the older write, so its seq only grows and
+				// readers never take the bytes of two writes for one value. wait while an older one still copies its value
+				auto seq = cell->seq.load(std::memory_order_acquire);
+				for (;;)
 				{
-					auto p = conn.first;
-					auto tmp = conn.second.lock();
-					if (nullptr != tmp)
+					if (seq > 2 * index)
+						return;// a later lap has the cell already, readers count the value as dropped
+					if (seq & 1)
 					{
-						signal->ConnectInternal(p, std::dynamic_pointer_cast<Connection<Signature>>(tmp));
+						std::this_thread::yield();
+						seq = cell->seq.load(std::memory_order_acquire);
 					}
+					else if (cell->seq.compare_exchange_weak(seq, 2 * index + 1, std::memory_order_acquire, std::memory_order_acquire))
+						break;
 				}
-				early_conns_.erase(conns_iter);
+				std::atomic_thread_fence(std::memory_order_release);
+				std::memcpy(reinterpret_cast<unsigned char*>(cell) + ValueOffset(alignof(T)), &value, sizeof(T));
+				cell->seq.store(2 * index + 2, std::memory_order_release);
 			}
+		};
+	private:
+		// the connections of this process to one signal of the segment
+		class Reader
+		{
+		public:
+			std::string name_;// of the signal, readers_ is keyed by its hash
+			uint64_t dropped_ = 0;
+			virtual ~Reader(){}
+			virtual size_t Poll(SharedSignalHub& hub, size_t max) = 0;
+		};
+		template<typename T>
+		class TypedReader :
+			public Reader
+		{
+		public:
+			SignalType<T> signal_;
+			SignalId id_;// a view of name_
+			SignalEntry* entry_ = nullptr;// until a producer adds the signal
+			unsigned char* cells_ = nullptr;
+			uint64_t cursor_ = 0;// the index of the next value to deliver
 
-			signal->deleter_ = [this, sig_name](void* p)
+			explicit TypedReader(const SignalId& sig_name) : id_(sig_name)
 			{
-				std::lock_guard<decltype(lock_)> l(lock_);
-				auto sig_iter = signals_.find(sig_name);
-				if (signals_.end() != sig_iter)
+				this->name_ = sig_name.Name();
+				signal_.name_ = this->name_;
+				id_ = SignalId(this->name_);
+			}
+			// false while the segment has no such signal
+			bool Resolve(SharedSignalHub& hub, bool from_start)
+			{
+				if (entry_)
+					return true;
+				auto entry = hub.Find(id_);
+				if (nullptr == entry)
+					return false;
+				if (entry->size != sizeof(T) || entry->alignment != alignof(T))
 				{
-					if (p == sig_iter->second.first)
-					{
-						// we are the last one
-						signals_.erase(sig_iter);
+					assert(false); // the signal was added with another type
+					return false;
+				}
+				entry_ = entry;
+				cells_ = hub.Base() + entry->offset;
+				cursor_ = from_start ? 0 : entry->head.load(std::memory_order_acquire);
+				return true;
+			}
+			// when the producers lapped us, skip to the oldest value the ring still has
+			void CatchUp(uint64_t head)
+			{
+				if (head - cursor_ > entry_->mask + 1)
+				{
+					this->dropped_ += head - cursor_ - (entry_->mask + 1);
+					cursor_ = head - (entry_->mask + 1);
+				}
+			}
+			size_t Poll(SharedSignalHub& hub, size_t max) override
+			{
+				// values emitted before a late resolve were emitted after we connected
+				if (!Resolve(hub, true))
+					return 0;
+				size_t count = 0;
+				auto head = entry_->head.load(std::memory_order_acquire);
+				CatchUp(head);
+				while (count < max && cursor_ < head)
+				{
+					auto cell = reinterpret_cast<Cell*>(cells_ + (cursor_ & entry_->mask) * entry_->stride);
+					auto expected = 2 * cursor_ + 2;
+					auto seq = cell->seq.load(std::memory_order_acquire);
+					if (seq < expected)
+						break;// claimed but not written yet
+					typename std::aligned_storage<sizeof(T), alignof(T)>::type value;
+					std::memcpy(&value, reinterpret_cast<unsigned char*>(cell) + ValueOffset(alignof(T)), sizeof(T));
+					std::atomic_thread_fence(std::memory_order_acquire);
+					if (seq != expected || cell->seq.load(std::memory_order_relaxed) != expected)
+					{// overwritten by a later lap
+						head = entry_->head.load(std::memory_order_acquire);
+						++this->dropped_;
+						++cursor_;
+						CatchUp(head);
+						continue;
 					}
+					++cursor_;
+					++count;
+					signal_(*reinterpret_cast<const T*>(&value));
 				}
-			};
+				return count;
+			}
+		};
+		std::string segment_;
+		Header* header_ = nullptr;
+		size_t size_ = 0;
+		int error_ = 0;// the errno of what failed when not Opened()
+		typename ThreadingModel::Lock lock_;
+		std::map<uint64_t, std::unique_ptr<Reader>> readers_;// by name hash, its nodes stay put while slots connect during Poll
 
-			auto result = std::shared_ptr<Signal<Signature, Mutex>>(signal, [](Signal<Signature, Mutex>* p)
+		unsigned char* Base() const { return reinterpret_cast<unsigned char*>(header_); }
+		SignalEntry* Entries() const { return reinterpret_cast<SignalEntry*>(Base() + Align(sizeof(Header), alignof(SignalEntry))); }
+		// lock-free, entries are filled before they are marked ready and never change after
+		SignalEntry* Find(const SignalId& sig_name) const
+		{
+			if (nullptr == header_)
+				return nullptr;
+			auto entries = Entries();
+			auto mask = header_->capacity - 1;
+			for (auto i = sig_name.Hash() & mask, probes = mask + 1; probes; i = (i + 1) & mask, --probes)
 			{
-				// do not refer to this in destructor, instead, place clean logic in deleter_
-				if (p->deleter_)
-					p->deleter_(p);
-				delete p;
-			});
-
-			std::lock_guard<decltype(lock_)> l(lock_);
-			signals_[sig_name] = std::make_pair(signal,result);
-			return result;
+				auto&& entry = entries[i];
+				if (!entry.ready.load(std::memory_order_acquire))
+					return nullptr;
+				if (entry.hash == sig_name.Hash() && sig_name.Is(static_cast<const char*>(entry.name)))
+					return &entry;
+			}
+			return nullptr;
+		}
+		bool Map(int fd, size_t size)
+		{
+			auto p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (MAP_FAILED == p)
+			{
+				error_ = errno;
+				return false;
+			}
+			header_ = static_cast<Header*>(p);
+			size_ = size;
+			return true;
+		}
+		bool Create(int fd, size_t size, size_t signals)
+		{
+			size_t capacity = 1;
+			while (capacity < signals)
+				capacity *= 2;
+			auto used = Align(Align(sizeof(Header), alignof(SignalEntry)) + capacity * sizeof(SignalEntry), 64);
+			if (used >= size)
+			{
+				error_ = EINVAL;// no room for the signal table
+				return false;
+			}
+			if (0 != ftruncate(fd, static_cast<off_t>(size)))
+			{
+				error_ = errno;
+				return false;
+			}
+			if (!Map(fd, size))
+				return false;
+			// a fresh segment is zero filled, which is what the atomics start from
+			auto header = new (header_) Header;
+			header->size = size;
+			header->capacity = capacity;
+			header->used.store(used, std::memory_order_relaxed);
+			header->lock.store(0, std::memory_order_relaxed);
+			header->magic.store(Magic, std::memory_order_release);
+			return true;
+		}
+		bool Attach(int fd)
+		{
+			struct stat st;
+			// the process making the segment may not have sized or filled it yet
+			for (int i = 0; i < 1000; ++i)
+			{
+				if (0 != fstat(fd, &st))
+				{
+					error_ = errno;
+					return false;
+				}
+				if (st.st_size > 0)
+					break;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			if (st.st_size <= 0)
+			{
+				error_ = ETIMEDOUT;
+				return false;
+			}
+			if (!Map(fd, static_cast<size_t>(st.st_size)))
+				return false;
+			for (int i = 0; i < 1000; ++i)
+			{
+				if (Magic == header_->magic.load(std::memory_order_acquire))
+					return true;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			error_ = ETIMEDOUT;
+			return false;
+		}
+		void Lock()
+		{
+			uint32_t expected = 0;
+			while (!header_->lock.compare_exchange_weak(expected, 1, std::memory_order_acquire))
+			{
+				expected = 0;
+				std::this_thread::yield();
+			}
+		}
+		void Unlock() { header_->lock.store(0, std::memory_order_release); }
+	public:
+		/*
+		segment : the name of the segment, "/name" by POSIX rules. the first process to use it makes it with size bytes
+		and room for signals signals, the others attach to it as it is. check Opened(), and Error() when it failed.
+		a segment which could not be made is removed again, so it doesn't stall the processes coming next
+		*/
+		explicit SharedSignalHub(const std::string& segment, size_t size = 64 << 20, size_t signals = 256) :
+			segment_(segment)
+		{
+			auto fd = shm_open(segment.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+			bool ok = false;
+			if (fd >= 0)
+			{
+				ok = Create(fd, size, signals);
+				if (!ok)
+					shm_unlink(segment.c_str());
+			}
+			else if (EEXIST == errno && (fd = shm_open(segment.c_str(), O_RDWR, 0600)) >= 0)
+				ok = Attach(fd);
+			else
+				error_ = errno;
+			if (fd >= 0)
+				close(fd);
+			if (!ok && header_)
+			{
+				munmap(header_, size_);
+				header_ = nullptr;
+			}
+		}
+		SharedSignalHub(const SharedSignalHub&) = delete;
+		SharedSignalHub& operator=(const SharedSignalHub&) = delete;
+		~SharedSignalHub()
+		{
+			readers_.clear();
+			if (header_)
+				munmap(header_, size_);
 		}
+		bool Opened() const { return nullptr != header_; }
+		// why the segment could not be opened, an errno: EINVAL when size has no room for the signals, ETIMEDOUT when the
+		// process making it did not finish within a second
+		int Error() const { return error_; }
+		// removes the name of the segment, processes attached to it keep it until they let go
+		static bool Remove(const std::string& segment) { return 0 == shm_unlink(segment.c_str()); }
 
 		/*
-		save the return value as long as you want to keep the connection
-		sig_name : required, unique, used to bind sig-slot
-		slot_name : optional, for debug purpose
+		adds a signal of T with a ring of capacity values, rounded up to a power of two, or finds the one of that name.
+		the emitter is invalid when the segment is full or has the signal with another type
 		*/
-		template<typename Signature>
-		auto Connect(std::string sig_name, std::function<Signature> func, std::string slot_name = "") -> std::shared_ptr<Connection<Signature>>
+		template<typename T>
+		auto AddSignal(SignalId sig_name, size_t capacity = 4096) -> SharedEmitter<T>
 		{
-			std::lock_guard<decltype(lock_)> l(lock_);
-			auto sig_iter = signals_.find(sig_name);
-			if (signals_.end() != sig_iter)
+			static_assert(std::is_trivially_copyable<T>::value, "the values of a shared signal are copied as bytes");
+			SharedEmitter<T> result;
+			auto name = sig_name.Name();
+			if (nullptr == header_ || name.size() >= sizeof(SignalEntry::name))
+				return result;
+			size_t cells = 1;
+			while (cells < capacity)
+				cells *= 2;
+			auto stride = Align(ValueOffset(alignof(T)) + sizeof(T), std::max(alignof(T), alignof(Cell)));
+
+			Lock();
+			auto entries = Entries();
+			auto mask = header_->capacity - 1;
+			SignalEntry* entry = nullptr;
+			for (auto i = sig_name.Hash() & mask, probes = mask + 1; probes; i = (i + 1) & mask, --probes)
 			{
-				auto signal = sig_iter->second.second.lock();
-				if (nullptr != signal)
+				if (!entries[i].ready.load(std::memory_order_relaxed) ||
+					(entries[i].hash == sig_name.Hash() && name == entries[i].name))
 				{
-					return std::dynamic_pointer_cast<Signal<Signature, Mutex>>(signal)->Connect(func, slot_name);
+					entry = &entries[i];
+					break;
 				}
 			}
-
-			// the signal is not available now, store to a weak_ptr first
-			auto conn = new Connection<Signature>();
-			conn->slot_ = func;
-			conn->name_ = slot_name;
-			conn->sig_name_ = sig_name;
-			conn->deleter_ = [this, sig_name](void* p)
+			if (entry && !entry->ready.load(std::memory_order_relaxed))
 			{
-				std::lock_guard<decltype(lock_)> l(lock_);
-				auto conns_iter = early_conns_.find(sig_name);
-				if (conns_iter != early_conns_.end())
+				auto offset = Align(header_->used.load(std::memory_order_relaxed), std::max<size_t>(64, alignof(T)));
+				if (offset + cells * stride <= header_->size)
 				{
-					auto&& conns = conns_iter->second;
-					auto conn_iter = std::find_if(conns.begin(), conns.end(), [p](WeakConnection iter) -> bool
-					{
-						return iter.first == p;
-					});
-					if (conn_iter != conns.end())
-					{
-						conns.erase(conn_iter);
-					}
+					header_->used.store(offset + cells * stride, std::memory_order_relaxed);
+					entry->size = sizeof(T);
+					entry->alignment = alignof(T);
+					entry->stride = static_cast<uint32_t>(stride);
+					entry->hash = sig_name.Hash();
+					entry->mask = cells - 1;
+					entry->offset = offset;
+					std::memcpy(entry->name, name.c_str(), name.size() + 1);
+					entry->head.store(0, std::memory_order_relaxed);
+					entry->ready.store(1, std::memory_order_release);
 				}
-			};
-
-			auto result = std::shared_ptr<Connection<Signature>>(conn, [](Connection<Signature>* p)
+				else
+					entry = nullptr;
+			}
+			Unlock();
+			if (entry && entry->size == sizeof(T) && entry->alignment == alignof(T))
 			{
-				if (p->deleter_)
-					p->deleter_(p);
-				delete p;
-			});
-			early_conns_[sig_name].push_back(std::make_pair(conn, std::weak_ptr<Connection<Signature>>(result)));
+				result.entry_ = entry;
+				result.cells_ = Base() + entry->offset;
+			}
 			return result;
 		}
-
-		template <typename Signature, typename ...Params>
-		void Emit(std::string sig_name, Params&&... params)
+		// a lookup and an emit, keep the emitter of AddSignal to skip the lookup. nothing happens without such a signal
+		template<typename T>
+		void Emit(SignalId sig_name, const T& value)
+		{
+			auto entry = Find(sig_name);
+			if (nullptr == entry || entry->size != sizeof(T) || entry->alignment != alignof(T))
+				return;
+			SharedEmitter<T> emitter;
+			emitter.entry_ = entry;
+			emitter.cells_ = Base() + entry->offset;
+			emitter.Emit(value);
+		}
+		/*
+		the slot gets the values of the signal emitted from now on, by any process, when this one calls Poll().
+		the signal may be added later, the slot then gets all of its values. nullptr when this process connected another name
+		with the same hash before
+		*/
+		template<typename T>
+		auto Connect(SignalId sig_name, typename SignalType<T>::SlotType func, std::string slot_name = "") -> ConnectionPtr<T>
 		{
-			std::shared_ptr<SignalBase> signal = nullptr;
+			static_assert(std::is_trivially_copyable<T>::value, "the values of a shared signal are copied as bytes");
+			std::lock_guard<decltype(lock_)> l(lock_);
+			auto&& reader = readers_[sig_name.Hash()];
+			if (!reader)
 			{
-				std::lock_guard<decltype(lock_)> l(lock_);
-				auto sig_iter = signals_.find(sig_name);
-				if (signals_.end() == sig_iter)
-					return;
-
-				signal = sig_iter->second.second.lock();
-				if (nullptr == signal)
-					return;
+				auto typed = new TypedReader<T>(sig_name);
+				reader.reset(typed);
+				typed->Resolve(*this, false);
+			}
+			if (!sig_name.Is(reader->name_))
+				return nullptr;// another name with the same hash
+			auto typed = dynamic_cast<TypedReader<T>*>(reader.get());
+			if (nullptr == typed)
+			{
+				assert(false); // connected before with another type
+				return nullptr;
 			}
-			(*std::dynamic_pointer_cast<Signal<Signature, Mutex>>(signal))(params...);
+			return typed->signal_.Connect(std::move(func), std::move(slot_name));
+		}
+		// calls the slots of this process with what was emitted since the last Poll, up to max values per signal; returns how many
+		size_t Poll(size_t max = static_cast<size_t>(-1))
+		{
+			std::lock_guard<decltype(lock_)> l(lock_);
+			size_t count = 0;
+			for (auto&& item : readers_)
+				count += item.second->Poll(*this, max);
+			return count;
+		}
+		// how many values of the signal this process skipped because its ring had moved past them
+		uint64_t Dropped(SignalId sig_name)
+		{
+			std::lock_guard<decltype(lock_)> l(lock_);
+			auto it = readers_.find(sig_name.Hash());
+			return readers_.end() == it || !sig_name.Is(it->second->name_) ? 0 : it->second->dropped_;
 		}
 	};
+#endif
 }
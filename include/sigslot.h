@@ -2,112 +2,2421 @@
 
 #include <memory>
 #include <functional>
-#include <list>
 #include <atomic>
 #include <mutex>
 #include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <tuple>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
+#include <unordered_map>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include <coroutine>
+#include <optional>
+#define SIGSLOT_COROUTINES
+#endif
 
+namespace nsSigslot
+{
+	// where an object is stored by its owner, see SlotMap
+	struct SlotKey
+	{
+		uint32_t index;
+		uint32_t generation;// bumped on every Erase, so stale keys never match a reused slot
+	};
+
+	// a lock which does nothing, for objects used by a single thread
+	struct NullMutex
+	{
+		void lock() {}
+		bool try_lock() { return true; }
+		void unlock() {}
+	};
+
+	// a std::atomic look-alike for values which never leave their thread
+	template<typename T>
+	class PlainAtomic
+	{
+		T value_;
+	public:
+		PlainAtomic(T value = T()) : value_(value) {}
+		PlainAtomic(const PlainAtomic&) = delete;
+		PlainAtomic& operator=(const PlainAtomic&) = delete;
+		T load(std::memory_order = std::memory_order_seq_cst) const { return value_; }
+		void store(T value, std::memory_order = std::memory_order_seq_cst) { value_ = value; }
+		T fetch_add(T arg, std::memory_order = std::memory_order_seq_cst) { auto old = value_; value_ += arg; return old; }
+		T fetch_sub(T arg, std::memory_order = std::memory_order_seq_cst) { auto old = value_; value_ -= arg; return old; }
+		bool compare_exchange_strong(T& expected, T desired, std::memory_order = std::memory_order_seq_cst)
+		{
+			if (value_ != expected)
+			{
+				expected = value_;
+				return false;
+			}
+			value_ = desired;
+			return true;
+		}
+		T operator=(T value) { value_ = value; return value; }
+		operator T() const { return value_; }
+	};
+
+	// the control block of a LocalPtr, the object lives inside it
+	class LocalControl
+	{
+		size_t strong_ = 0;
+		size_t weak_ = 0;
+		template<typename>
+		friend class LocalPtr;
+		template<typename>
+		friend class LocalWeakPtr;
+
+		void AddStrong() { ++strong_; }
+		void ReleaseStrong()
+		{
+			if (0 != --strong_)
+				return;
+			++weak_;// the object may drop weak references to itself while it is destroyed
+			Destroy();
+			ReleaseWeak();
+		}
+		void AddWeak() { ++weak_; }
+		void ReleaseWeak()
+		{
+			if (0 == --weak_ && 0 == strong_)
+				Free();
+		}
+	protected:
+		virtual void Destroy() = 0;
+		virtual void Free() { delete this; }
+	public:
+		virtual ~LocalControl() {}
+	};
+
+	template<typename T>
+	class LocalBlock :
+		public LocalControl
+	{
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_;
+	public:
+		template<typename ...Args>
+		LocalBlock(Args&&... args) { new (&storage_) T(std::forward<Args>(args)...); }
+		T* Get() { return reinterpret_cast<T*>(&storage_); }
+	protected:
+		void Destroy() override { Get()->~T(); }
+	};
+
+	// a LocalBlock allocated by an allocator, made by PlainAccess::AllocateShared
+	template<typename T, typename Alloc>
+	class LocalAllocatedBlock :
+		public LocalBlock<T>
+	{
+		typedef typename std::allocator_traits<Alloc>::template rebind_alloc<LocalAllocatedBlock> BlockAlloc;
+		BlockAlloc alloc_;
+	public:
+		template<typename ...Args>
+		LocalAllocatedBlock(const Alloc& alloc, Args&&... args) : LocalBlock<T>(std::forward<Args>(args)...), alloc_(alloc) {}
+	protected:
+		void Free() override
+		{
+			BlockAlloc alloc(alloc_);
+			this->~LocalAllocatedBlock();
+			std::allocator_traits<BlockAlloc>::deallocate(alloc, this, 1);
+		}
+	};
+
+	// std::shared_ptr with plain reference counts, for objects which never leave their thread. made by PlainAccess::MakeShared
+	template<typename T>
+	class LocalPtr
+	{
+		template<typename>
+		friend class LocalPtr;
+		template<typename>
+		friend class LocalWeakPtr;
+		friend struct PlainAccess;
+		T* ptr_ = nullptr;
+		LocalControl* control_ = nullptr;
+
+		LocalPtr(T* ptr, LocalControl* control) : ptr_(ptr), control_(control)
+		{
+			if (control_)
+				control_->AddStrong();
+		}
+	public:
+		typedef T element_type;
+		LocalPtr() {}
+		LocalPtr(std::nullptr_t) {}
+		LocalPtr(const LocalPtr& other) : LocalPtr(other.ptr_, other.control_) {}
+		LocalPtr(LocalPtr&& other) : ptr_(other.ptr_), control_(other.control_)
+		{
+			other.ptr_ = nullptr;
+			other.control_ = nullptr;
+		}
+		template<typename U, typename = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+		LocalPtr(const LocalPtr<U>& other) : LocalPtr(other.ptr_, other.control_) {}
+		template<typename U, typename = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+		LocalPtr(LocalPtr<U>&& other) : ptr_(other.ptr_), control_(other.control_)
+		{
+			other.ptr_ = nullptr;
+			other.control_ = nullptr;
+		}
+		~LocalPtr() { reset(); }
+		LocalPtr& operator=(LocalPtr other)
+		{
+			swap(other);
+			return *this;
+		}
+		void swap(LocalPtr& other)
+		{
+			std::swap(ptr_, other.ptr_);
+			std::swap(control_, other.control_);
+		}
+		void reset()
+		{
+			auto control = control_;
+			ptr_ = nullptr;
+			control_ = nullptr;
+			if (control)
+				control->ReleaseStrong();
+		}
+		T* get() const { return ptr_; }
+		T& operator*() const { return *ptr_; }
+		T* operator->() const { return ptr_; }
+		explicit operator bool() const { return nullptr != ptr_; }
+		friend bool operator==(const LocalPtr& p, std::nullptr_t) { return nullptr == p.ptr_; }
+		friend bool operator==(std::nullptr_t, const LocalPtr& p) { return nullptr == p.ptr_; }
+		friend bool operator!=(const LocalPtr& p, std::nullptr_t) { return nullptr != p.ptr_; }
+		friend bool operator!=(std::nullptr_t, const LocalPtr& p) { return nullptr != p.ptr_; }
+	};
+
+	// std::weak_ptr for LocalPtr
+	template<typename T>
+	class LocalWeakPtr
+	{
+		template<typename>
+		friend class LocalWeakPtr;
+		T* ptr_ = nullptr;
+		LocalControl* control_ = nullptr;
+
+		LocalWeakPtr(T* ptr, LocalControl* control) : ptr_(ptr), control_(control)
+		{
+			if (control_)
+				control_->AddWeak();
+		}
+	public:
+		LocalWeakPtr() {}
+		LocalWeakPtr(const LocalWeakPtr& other) : LocalWeakPtr(other.ptr_, other.control_) {}
+		LocalWeakPtr(LocalWeakPtr&& other) : ptr_(other.ptr_), control_(other.control_)
+		{
+			other.ptr_ = nullptr;
+			other.control_ = nullptr;
+		}
+		template<typename U, typename = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+		LocalWeakPtr(const LocalWeakPtr<U>& other) : LocalWeakPtr(other.ptr_, other.control_) {}
+		template<typename U, typename = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+		LocalWeakPtr(const LocalPtr<U>& other) : LocalWeakPtr(other.ptr_, other.control_) {}
+		~LocalWeakPtr() { reset(); }
+		LocalWeakPtr& operator=(LocalWeakPtr other)
+		{
+			std::swap(ptr_, other.ptr_);
+			std::swap(control_, other.control_);
+			return *this;
+		}
+		void reset()
+		{
+			auto control = control_;
+			ptr_ = nullptr;
+			control_ = nullptr;
+			if (control)
+				control->ReleaseWeak();
+		}
+		bool expired() const { return nullptr == control_ || 0 == control_->strong_; }
+		LocalPtr<T> lock() const { return expired() ? LocalPtr<T>() : LocalPtr<T>(ptr_, control_); }
+	};
+
+	/*
+	tells when memory swapped out from under lock-free readers can be freed: a reader announces the epoch it starts in, a writer
+	stamps what it swapped out with the epoch it ends, and frees it once no reader still in its section announced an epoch as old.
+	the sections of a thread nest, the outermost announces; a thread takes a record on first use and gives it back when it exits
+	*/
+	class AtomicEpoch
+	{
+		struct Record
+		{
+			std::atomic<uint64_t> active{ 0 };// the epoch announced, 0 outside sections
+			std::atomic<bool> used{ true };
+			uint32_t depth = 0;// of nested sections, only touched by the thread holding the record
+			Record* next = nullptr;// records are never freed, so readers of the list need no care
+			char padding[64];// keeps the records of two threads off one cache line
+		};
+		std::atomic<uint64_t> epoch_{ 1 };
+		std::atomic<Record*> records_{ nullptr };
+
+		static AtomicEpoch& Instance()
+		{
+			static AtomicEpoch epoch;
+			return epoch;
+		}
+		// gives the record of a thread back when it exits
+		struct Holder
+		{
+			Record* record_ = nullptr;
+			~Holder()
+			{
+				if (record_)
+					record_->used.store(false, std::memory_order_release);
+			}
+		};
+		static Record& Here()
+		{
+			static thread_local Holder holder;
+			if (nullptr == holder.record_)
+				holder.record_ = Instance().Take();
+			return *holder.record_;
+		}
+		Record* Take()
+		{
+			for (auto record = records_.load(std::memory_order_acquire); record; record = record->next)
+			{
+				bool expected = false;
+				if (!record->used.load(std::memory_order_relaxed) && record->used.compare_exchange_strong(expected, true, std::memory_order_acquire))
+					return record;
+			}
+			auto record = new Record;
+			record->next = records_.load(std::memory_order_relaxed);
+			while (!records_.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed))
+				;
+			return record;
+		}
+	public:
+		// held by a reader while it uses what a writer may swap out; seq_cst, so a writer's scan of the records sees the epoch
+		// of any reader which could have loaded what it swapped out
+		class Guard
+		{
+			Record& record_;
+		public:
+			Guard() : record_(Here())
+			{
+				if (0 == record_.depth++)
+					record_.active.store(Instance().epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+			}
+			~Guard()
+			{
+				if (0 == --record_.depth)
+					record_.active.store(0, std::memory_order_release);
+			}
+			Guard(const Guard&) = delete;
+			Guard& operator=(const Guard&) = delete;
+		};
+		// the stamp of what a writer swapped out, with a seq_cst store, just before
+		static uint64_t Retire() { return Instance().epoch_.fetch_add(1, std::memory_order_seq_cst); }
+		// what was stamped before it is no longer read by anyone
+		static uint64_t Oldest()
+		{
+			auto oldest = ~uint64_t(0);
+			for (auto record = Instance().records_.load(std::memory_order_acquire); record; record = record->next)
+			{
+				auto active = record->active.load(std::memory_order_seq_cst);
+				if (0 != active && active < oldest)
+					oldest = active;
+			}
+			return oldest;
+		}
+	};
+	// the AtomicEpoch of one thread, for PlainAccess: what a writer swapped out can go when the thread is in no section
+	class LocalEpoch
+	{
+		static uint32_t& Depth()
+		{
+			static thread_local uint32_t depth = 0;
+			return depth;
+		}
+	public:
+		struct Guard
+		{
+			Guard() { ++Depth(); }
+			~Guard() { --Depth(); }
+			Guard(const Guard&) = delete;
+			Guard& operator=(const Guard&) = delete;
+		};
+		static uint64_t Retire() { return 0; }
+		static uint64_t Oldest() { return 0 == Depth() ? 1 : 0; }
+	};
+
+	// how state reachable from several objects is shared: atomically, or with plain loads, stores and counts
+	struct AtomicAccess
+	{
+		template<typename T>
+		using Atomic = std::atomic<T>;
+		template<typename T>
+		using SharedPtr = std::shared_ptr<T>;
+		template<typename T>
+		using WeakPtr = std::weak_ptr<T>;
+
+		template<typename T, typename ...Args>
+		static std::shared_ptr<T> MakeShared(Args&&... args) { return std::make_shared<T>(std::forward<Args>(args)...); }
+		template<typename T, typename Alloc, typename ...Args>
+		static std::shared_ptr<T> AllocateShared(const Alloc& alloc, Args&&... args) { return std::allocate_shared<T>(alloc, std::forward<Args>(args)...); }
+		template<typename T, typename U>
+		static std::shared_ptr<T> DynamicCast(const std::shared_ptr<U>& p) { return std::dynamic_pointer_cast<T>(p); }
+		typedef AtomicEpoch Epoch;
+	};
+	struct PlainAccess
+	{
+		template<typename T>
+		using Atomic = PlainAtomic<T>;
+		template<typename T>
+		using SharedPtr = LocalPtr<T>;
+		template<typename T>
+		using WeakPtr = LocalWeakPtr<T>;
+
+		template<typename T, typename ...Args>
+		static LocalPtr<T> MakeShared(Args&&... args)
+		{
+			auto block = new LocalBlock<T>(std::forward<Args>(args)...);
+			return LocalPtr<T>(block->Get(), block);
+		}
+		template<typename T, typename Alloc, typename ...Args>
+		static LocalPtr<T> AllocateShared(const Alloc& alloc, Args&&... args)
+		{
+			typedef LocalAllocatedBlock<T, Alloc> Block;
+			typename std::allocator_traits<Alloc>::template rebind_alloc<Block> block_alloc(alloc);
+			auto block = new (std::allocator_traits<decltype(block_alloc)>::allocate(block_alloc, 1)) Block(alloc, std::forward<Args>(args)...);
+			return LocalPtr<T>(block->Get(), block);
+		}
+		template<typename T, typename U>
+		static LocalPtr<T> DynamicCast(const LocalPtr<U>& p)
+		{
+			auto ptr = dynamic_cast<T*>(p.get());
+			return ptr ? LocalPtr<T>(ptr, p.control_) : LocalPtr<T>();
+		}
+		typedef LocalEpoch Epoch;
+	};
+
+	/*
+	threading models, given to Signal, ObjectContainer and SignalHub in place of a mutex
+	MultiThreaded : objects may be shared by threads, Mutex guards them and flags and reference counts are atomic
+	SingleThreaded : everything stays on one thread, no locking and plain counters; connections are LocalPtr instead of std::shared_ptr
+	a plain mutex type is taken as MultiThreaded<mutex>
+	*/
+	template<typename Mutex = std::recursive_mutex>
+	struct MultiThreaded :
+		AtomicAccess
+	{
+		typedef Mutex Lock;
+		typedef AtomicAccess Access;
+	};
+	struct SingleThreaded :
+		PlainAccess
+	{
+		typedef NullMutex Lock;
+		typedef PlainAccess Access;
+	};
+	template<typename T>
+	struct ThreadingOf { typedef MultiThreaded<T> type; };
+	template<typename Mutex>
+	struct ThreadingOf<MultiThreaded<Mutex>> { typedef MultiThreaded<Mutex> type; };
+	template<>
+	struct ThreadingOf<SingleThreaded> { typedef SingleThreaded type; };
+
+	template<typename Access>
+	class BasicObjectBase;
+	// keeps weak references to objects, gets told when one of them goes away
+	template<typename Access>
+	class BasicOwnerBase
+	{
+	public:
+		virtual void Detach(BasicObjectBase<Access>* p, SlotKey key) = 0;
+	protected:
+		~BasicOwnerBase(){}
+	};
+
+	/*
+	the switch an ObjectContainer turns its objects on and off with, shared by the container and the objects saved to it.
+	the last Enable() wins, of a container or of the object itself: both store a state stamped from one clock, the newest counts
+	*/
+	template<typename Access>
+	class BasicEnableGate
+	{
+		typename Access::template Atomic<uint64_t> state_{ 1 };// see Stamp, enabled before any Enable()
+		typename Access::template Atomic<size_t> refs_{ 1 };
+	public:
+		BasicEnableGate() = default;
+		BasicEnableGate(const BasicEnableGate&) = delete;
+		BasicEnableGate& operator=(const BasicEnableGate&) = delete;
+		void AddRef(){ refs_.fetch_add(1, std::memory_order_relaxed); }
+		void Release()
+		{
+			if (1 == refs_.fetch_sub(1, std::memory_order_acq_rel))
+				delete this;
+		}
+		// a state newer than all stamped before: the stamp shifted left, enable in the low bit. the clock is shared by every
+		// thread, even with SingleThreaded, since objects of different threads may be enabled at once
+		static uint64_t Stamp(bool enable)
+		{
+			static std::atomic<uint64_t> clock{ 0 };
+			return ((clock.fetch_add(1, std::memory_order_relaxed) + 1) << 1) | (enable ? 1 : 0);
+		}
+		void Enable(bool enable = true){ state_.store(Stamp(enable), std::memory_order_release); }
+		uint64_t State(){ return state_.load(std::memory_order_acquire); }
+	};
+
+	template<typename Access>
+	class BasicObjectBase
+	{
+	protected:
+		typedef BasicEnableGate<Access> Gate;
+		// the gates of the containers after the first one we were saved to, never removed before we go away
+		struct GateLink
+		{
+			Gate* gate;
+			GateLink* next;
+		};
+		typename Access::template Atomic<uint64_t> enable_{ 1 };// stamped as the state of a Gate
+		typename Access::template Atomic<bool> orphaned_{ false };// set by OnFinal
+		typename Access::template Atomic<Gate*> gate_{ nullptr };// the gate of the first container we were saved to, see Join
+		typename Access::template Atomic<GateLink*> more_gates_{ nullptr };
+		BasicOwnerBase<Access>* owner_ = nullptr;// we need to clear this before the owner goes away
+		SlotKey key_ = SlotKey{ 0xffffffff, 0 };
+	public:
+		virtual ~BasicObjectBase()
+		{
+			if (owner_)
+				owner_->Detach(this, key_);
+			auto gate = gate_.load(std::memory_order_relaxed);
+			if (gate)
+				gate->Release();
+			auto link = more_gates_.load(std::memory_order_relaxed);
+			while (link)
+			{
+				auto next = link->next;
+				link->gate->Release();
+				delete link;
+				link = next;
+			}
+		}
+		virtual void OnFinal(){ owner_ = nullptr; orphaned_ = true; }
+		void Enable(bool enable = true){ enable_.store(Gate::Stamp(enable), std::memory_order_release); }
+		// whichever was switched last: our Enable() or that of an ObjectContainer we were saved to
+		bool Enabled()
+		{
+			auto state = enable_.load(std::memory_order_acquire);
+			auto gate = gate_.load(std::memory_order_acquire);
+			if (nullptr == gate)
+				return 0 != (state & 1);
+			state = std::max(state, gate->State());
+			for (auto link = more_gates_.load(std::memory_order_acquire); link; link = link->next)
+				state = std::max(state, link->gate->State());
+			return 0 != (state & 1);
+		}
+		// whether our owner went away, e.g. a connection whose signal is gone: nothing will ever call it again
+		bool Orphaned(){ return orphaned_; }
+		// follow the Enable() of gate too. we keep our state until it is switched again, as its earlier Enable() is older
+		void Join(Gate* gate)
+		{
+			auto state = enable_.load(std::memory_order_relaxed);
+			while (!enable_.compare_exchange_strong(state, Gate::Stamp(0 != (state & 1)), std::memory_order_acq_rel))
+				;
+			gate->AddRef();
+			Gate* expected = nullptr;
+			if (gate_.compare_exchange_strong(expected, gate, std::memory_order_acq_rel))
+				return;
+			auto joined = expected == gate;
+			for (auto link = more_gates_.load(std::memory_order_acquire); link && !joined; link = link->next)
+				joined = link->gate == gate;
+			if (joined)
+			{
+				gate->Release();
+				return;
+			}
+			auto link = new GateLink{ gate, more_gates_.load(std::memory_order_relaxed) };
+			while (!more_gates_.compare_exchange_strong(link->next, link, std::memory_order_acq_rel))
+				;
+		}
+	};
+	typedef BasicOwnerBase<AtomicAccess> OwnerBase;
+	typedef BasicObjectBase<AtomicAccess> ObjectBase;
+	typedef BasicEnableGate<AtomicAccess> EnableGate;
+
+	// a member function bound at compile time to an object: one pointer to copy, and a call the compiler can see through.
+	// what Connect<&Class::Method>(object) stores in the Slot of the connection
+	template<typename Method, Method method, typename Class>
+	struct MemberSlot
+	{
+		Class* object_;
+		template<typename ...Args>
+		auto operator()(Args&&... args) const -> decltype((object_->*method)(std::forward<Args>(args)...))
+		{
+			return (object_->*method)(std::forward<Args>(args)...);
+		}
+	};
+
+	// what Signal::Connect<&Class::Method> looks for in Class, see Trackable
+	template<typename Access>
+	class BasicTrackableBase
+	{
+	public:
+		virtual void Track(typename Access::template SharedPtr<BasicObjectBase<Access>> conn) = 0;
+	protected:
+		~BasicTrackableBase(){}
+	};
+
+	/*
+	derive a receiver from it and the member functions connected with signal.Connect<&Class::Method>(this) are disconnected when it
+	goes away: it keeps the connections, the signal a weak reference as usual, so emitting checks nothing more. it is destroyed
+	after the derived class, emissions on other threads must be over by then. copies start with no connection
+	*/
+	template<typename Threading = std::recursive_mutex>
+	class Trackable :
+		public BasicTrackableBase<typename ThreadingOf<Threading>::type::Access>
+	{
+		typedef typename ThreadingOf<Threading>::type ThreadingModel;
+		typedef typename ThreadingModel::template SharedPtr<BasicObjectBase<typename ThreadingModel::Access>> ObjectPtr;
+		typename ThreadingModel::Lock lock_;
+		std::vector<ObjectPtr> conns_;
+		size_t prune_at_ = 16;// conns_ is swept for the connections of dead signals when it reaches this size
+	public:
+		Trackable() {}
+		Trackable(const Trackable&) : Trackable() {}
+		Trackable& operator=(const Trackable&) { return *this; }
+		virtual ~Trackable() { DisconnectAll(); }
+		void Track(ObjectPtr conn) override
+		{
+			std::lock_guard<decltype(lock_)> l(lock_);
+			if (conns_.size() >= prune_at_)
+			{
+				conns_.erase(std::remove_if(conns_.begin(), conns_.end(), [](const ObjectPtr& item) { return item->Orphaned(); }), conns_.end());
+				prune_at_ = std::max<size_t>(16, conns_.size() * 2);
+			}
+			conns_.push_back(std::move(conn));
+		}
+		void DisconnectAll()
+		{
+			std::vector<ObjectPtr> conns;
+			{
+				std::lock_guard<decltype(lock_)> l(lock_);
+				conns.swap(conns_);
+			}
+			// released without our lock, they take the lock of their signal which may be calling us
+		}
+	};
+
+	// emission strategies, picked by Policy::Dispatch
+	// LockedDispatch : slots run with the signal's lock held, concurrent emitters wait for each other
+	// SnapshotDispatch : emitters read an immutable copy of the slot list in an Access::Epoch section, taking no lock and no
+	//                    reference count on the copy; each Connect() slot is still locked through its weak reference, ConnectScoped()
+	//                    slots are not. Connect and compaction pay for it by publishing a new copy
+	struct LockedDispatch {};
+	struct SnapshotDispatch {};
+
+	// a copy of the latency histogram of a slot
+	struct LatencyStats
+	{
+		uint64_t count = 0;
+		uint64_t total_ns = 0;
+		std::vector<uint64_t> buckets;// buckets[i] counts the calls which took [LatencyHistogram::LowerBound(i), LowerBound(i + 1)) ns
+		// the lower bound of the bucket holding the calls at fraction (0 to 1) of count
+		uint64_t Percentile(double fraction) const;
+	};
+	struct SlotMetrics
+	{
+		LatencyStats latency;
+	};
+	struct SignalMetrics
+	{
+		uint64_t emits = 0;
+		std::vector<SlotMetrics> slots;
+	};
+
+	/*
+	log-linear histogram of nanoseconds: each power of 2 is split into 4 buckets, so a bucket is at most 25% wide.
+	recording is one relaxed increment, values from 2^36 ns (about a minute) up share the last bucket
+	*/
+	class LatencyHistogram
+	{
+	public:
+		static const unsigned SubBits = 2;
+		static const size_t Buckets = (36 - SubBits + 1) << SubBits;
+	private:
+		std::atomic<uint64_t> buckets_[Buckets];
+		std::atomic<uint64_t> total_ns_{ 0 };
+
+		static unsigned Log2(uint64_t value)
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			return 63 - __builtin_clzll(value);
+#else
+			unsigned result = 0;
+			while (value >>= 1)
+				++result;
+			return result;
+#endif
+		}
+	public:
+		LatencyHistogram()
+		{
+			for (auto&& bucket : buckets_)
+				bucket.store(0, std::memory_order_relaxed);
+		}
+		static size_t Index(uint64_t ns)
+		{
+			if (ns < (1u << SubBits))
+				return static_cast<size_t>(ns);
+			auto exponent = Log2(ns);
+			auto index = ((exponent - SubBits + 1) << SubBits) + ((ns >> (exponent - SubBits)) & ((1u << SubBits) - 1));
+			return index < Buckets ? index : Buckets - 1;
+		}
+		static uint64_t LowerBound(size_t index)
+		{
+			if (index < (1u << SubBits))
+				return index;
+			auto exponent = (index >> SubBits) + SubBits - 1;
+			return (static_cast<uint64_t>((1u << SubBits) + (index & ((1u << SubBits) - 1)))) << (exponent - SubBits);
+		}
+		void Record(uint64_t ns)
+		{
+			buckets_[Index(ns)].fetch_add(1, std::memory_order_relaxed);
+			total_ns_.fetch_add(ns, std::memory_order_relaxed);
+		}
+		LatencyStats Read() const
+		{
+			LatencyStats result;
+			result.buckets.resize(Buckets);
+			for (size_t i = 0; i < Buckets; ++i)
+			{
+				result.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+				result.count += result.buckets[i];
+			}
+			result.total_ns = total_ns_.load(std::memory_order_relaxed);
+			return result;
+		}
+	};
+
+	inline uint64_t LatencyStats::Percentile(double fraction) const
+	{
+		auto rank = static_cast<uint64_t>(fraction * count);
+		uint64_t seen = 0;
+		for (size_t i = 0; i < buckets.size(); ++i)
+		{
+			seen += buckets[i];
+			if (seen > rank)
+				return LatencyHistogram::LowerBound(i);
+		}
+		return buckets.empty() ? 0 : LatencyHistogram::LowerBound(buckets.size() - 1);
+	}
+
+	// Policy::Metrics, keeps nothing and compiles away
+	struct NoMetrics
+	{
+		struct SignalCounters {};
+		struct ConnectionCounters {};
+		struct Tick {};
+		template<typename Signal>
+		static void Emitted(SignalCounters&, Signal&, uint64_t = 1) {}
+		static Tick Start() { return Tick(); }
+		template<typename Connection>
+		static void Invoked(ConnectionCounters&, Tick, Connection&) {}
+		static void Read(const SignalCounters&, SignalMetrics&) {}
+		static void Read(const ConnectionCounters&, SlotMetrics&) {}
+	};
+	// Policy::Metrics, counts the emits of each signal and times each slot call, read them with ReadMetrics()
+	struct CollectMetrics
+	{
+		struct SignalCounters
+		{
+			std::atomic<uint64_t> emits{ 0 };
+		};
+		typedef LatencyHistogram ConnectionCounters;
+		typedef std::chrono::steady_clock::time_point Tick;
+		template<typename Signal>
+		static void Emitted(SignalCounters& counters, Signal&, uint64_t count = 1) { counters.emits.fetch_add(count, std::memory_order_relaxed); }
+		static Tick Start() { return std::chrono::steady_clock::now(); }
+		template<typename Connection>
+		static void Invoked(ConnectionCounters& counters, Tick start, Connection&)
+		{
+			counters.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+		}
+		static void Read(const SignalCounters& counters, SignalMetrics& metrics) { metrics.emits = counters.emits.load(std::memory_order_relaxed); }
+		static void Read(const ConnectionCounters& counters, SlotMetrics& metrics) { metrics.latency = counters.Read(); }
+	};
+
+	/*
+	where TraceMetrics writes: a ring of the last Capacity records of each thread, written without a lock or a shared cache line
+	and read by Dump() while threads keep tracing. signals and slots are recorded by the id of their name, see Name().
+	times are raw ticks of Now(), the TSC where there is one; ChromeTrace() turns records into the JSON chrome://tracing
+	and Perfetto load. tracing starts disabled, Enable() is a switch every traced emission checks
+	*/
+	class Tracer
+	{
+	public:
+		enum Kind { EmitRecord, SlotRecord };
+		struct Record
+		{
+			uint64_t begin;// in ticks of Now()
+			uint64_t end;// the same as begin for emissions
+			uint64_t count;// the items of an EmitBatch, 1 otherwise
+			Kind kind;
+			uint32_t thread;// numbered from 1 in the order threads first traced
+			uint32_t signal;// a name id, 0 when unknown
+			uint32_t slot;// a name id, 0 for emissions
+		};
+		static const size_t Capacity = 4096;// records kept per thread, a power of two
+	private:
+		// written by its thread alone, each record is guarded by a sequence number odd while it is being written
+		struct Ring
+		{
+			struct Entry
+			{
+				std::atomic<uint64_t> seq{ 0 };
+				std::atomic<uint64_t> begin{ 0 };
+				std::atomic<uint64_t> end{ 0 };
+				std::atomic<uint64_t> count{ 0 };
+				std::atomic<uint64_t> ids{ 0 };// signal << 32 | slot
+				std::atomic<uint64_t> kind{ 0 };
+			};
+			std::atomic<uint64_t> head_{ 0 };// records written so far
+			uint32_t thread_;
+			Entry entries_[Capacity];
+			explicit Ring(uint32_t thread) : thread_(thread) {}
+		};
+		std::atomic<bool> enable_{ false };
+		std::mutex lock_;
+		std::vector<std::shared_ptr<Ring>> rings_;// of the threads which traced, kept after they exit until Clear()
+		uint32_t threads_ = 0;
+		std::vector<std::string> names_;// names_[id - 1]
+		std::unordered_map<std::string, uint32_t> ids_;
+		uint64_t start_ticks_;// the time the tracer was made, to scale ticks to time
+		std::chrono::steady_clock::time_point start_time_;
+
+		Tracer() : start_ticks_(Now()), start_time_(std::chrono::steady_clock::now()) {}
+		static Tracer& Instance()
+		{
+			static Tracer tracer;
+			return tracer;
+		}
+		static Ring& Here()
+		{
+			static thread_local std::shared_ptr<Ring> ring;
+			if (!ring)
+			{
+				auto&& tracer = Instance();
+				std::lock_guard<std::mutex> l(tracer.lock_);
+				ring = std::make_shared<Ring>(++tracer.threads_);
+				tracer.rings_.push_back(ring);
+			}
+			return *ring;
+		}
+		static void Escape(std::string& out, const std::string& text)
+		{
+			for (auto c : text)
+			{
+				if ('"' == c || '\\' == c)
+				{
+					out += '\\';
+					out += c;
+				}
+				else if (static_cast<unsigned char>(c) < 0x20)
+				{
+					char code[8];
+					snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+					out += code;
+				}
+				else
+					out += c;
+			}
+		}
+	public:
+		Tracer(const Tracer&) = delete;
+		Tracer& operator=(const Tracer&) = delete;
+		static void Enable(bool enable = true) { Instance().enable_.store(enable, std::memory_order_relaxed); }
+		static bool Enabled() { return Instance().enable_.load(std::memory_order_relaxed); }
+		// a cycle count where the CPU has one, nanoseconds of steady_clock otherwise
+		static uint64_t Now()
+		{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+			return __rdtsc();
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+			return __builtin_ia32_rdtsc();
+#else
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+		}
+		// the id of name, made on first use. cache : where the caller keeps it, 0 until then; name() is only called to make it
+		template<typename F>
+		static uint32_t Id(std::atomic<uint32_t>& cache, F&& name)
+		{
+			auto id = cache.load(std::memory_order_relaxed);
+			if (0 != id)
+				return id;
+			auto text = name();
+			auto&& tracer = Instance();
+			{
+				std::lock_guard<std::mutex> l(tracer.lock_);
+				auto it = tracer.ids_.find(text);
+				if (tracer.ids_.end() == it)
+				{
+					tracer.names_.push_back(text);
+					it = tracer.ids_.emplace(std::move(text), static_cast<uint32_t>(tracer.names_.size())).first;
+				}
+				id = it->second;
+			}
+			cache.store(id, std::memory_order_relaxed);
+			return id;
+		}
+		// the name of an id, empty for 0
+		static std::string Name(uint32_t id)
+		{
+			auto&& tracer = Instance();
+			std::lock_guard<std::mutex> l(tracer.lock_);
+			return 0 == id || id > tracer.names_.size() ? std::string() : tracer.names_[id - 1];
+		}
+		static void Write(Kind kind, uint32_t signal, uint32_t slot, uint64_t begin, uint64_t end, uint64_t count = 1)
+		{
+			auto&& ring = Here();
+			auto head = ring.head_.load(std::memory_order_relaxed);
+			auto&& entry = ring.entries_[head & (Capacity - 1)];
+			entry.seq.store(2 * head + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			entry.begin.store(begin, std::memory_order_relaxed);
+			entry.end.store(end, std::memory_order_relaxed);
+			entry.count.store(count, std::memory_order_relaxed);
+			entry.ids.store(static_cast<uint64_t>(signal) << 32 | slot, std::memory_order_relaxed);
+			entry.kind.store(kind, std::memory_order_relaxed);
+			entry.seq.store(2 * head + 2, std::memory_order_release);
+			ring.head_.store(head + 1, std::memory_order_release);
+		}
+		// the records of all threads which are still in their rings, by begin; those being overwritten meanwhile are left out
+		static std::vector<Record> Dump()
+		{
+			std::vector<std::shared_ptr<Ring>> rings;
+			{
+				auto&& tracer = Instance();
+				std::lock_guard<std::mutex> l(tracer.lock_);
+				rings = tracer.rings_;
+			}
+			std::vector<Record> result;
+			for (auto&& ring : rings)
+			{
+				auto head = ring->head_.load(std::memory_order_acquire);
+				for (auto i = head > Capacity ? head - Capacity : 0; i < head; ++i)
+				{
+					auto&& entry = ring->entries_[i & (Capacity - 1)];
+					if (entry.seq.load(std::memory_order_acquire) != 2 * i + 2)
+						continue;
+					Record record;
+					record.begin = entry.begin.load(std::memory_order_relaxed);
+					record.end = entry.end.load(std::memory_order_relaxed);
+					record.count = entry.count.load(std::memory_order_relaxed);
+					auto ids = entry.ids.load(std::memory_order_relaxed);
+					record.kind = static_cast<Kind>(entry.kind.load(std::memory_order_relaxed));
+					std::atomic_thread_fence(std::memory_order_acquire);
+					if (entry.seq.load(std::memory_order_relaxed) != 2 * i + 2)
+						continue;
+					record.thread = ring->thread_;
+					record.signal = static_cast<uint32_t>(ids >> 32);
+					record.slot = static_cast<uint32_t>(ids);
+					result.push_back(record);
+				}
+			}
+			std::sort(result.begin(), result.end(), [](const Record& a, const Record& b) { return a.begin < b.begin; });
+			return result;
+		}
+		// how many ticks of Now() make a microsecond, measured since the tracer was made
+		static double TicksPerMicrosecond()
+		{
+			auto&& tracer = Instance();
+			auto ticks = Now() - tracer.start_ticks_;
+			auto us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - tracer.start_time_).count();
+			return us > 0 && ticks > 0 ? ticks / us : 1000;
+		}
+		// records in the Trace Event Format: emissions are instant events, slot calls complete ones, by thread
+		static std::string ChromeTrace(const std::vector<Record>& records)
+		{
+			auto scale = TicksPerMicrosecond();
+			auto origin = records.empty() ? 0 : records.front().begin;
+			std::string result = "{\"traceEvents\":[";
+			char number[96];
+			for (size_t i = 0; i < records.size(); ++i)
+			{
+				auto&& record = records[i];
+				result += i ? ",\n{\"name\":\"" : "\n{\"name\":\"";
+				Escape(result, Name(SlotRecord == record.kind ? record.slot : record.signal));
+				if (SlotRecord == record.kind)
+				{
+					snprintf(number, sizeof(number), "\",\"cat\":\"slot\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+						record.thread, (record.begin - origin) / scale, (record.end - record.begin) / scale);
+					result += number;
+					if (record.signal)
+					{
+						result += ",\"args\":{\"signal\":\"";
+						Escape(result, Name(record.signal));
+						result += "\"}";
+					}
+					result += "}";
+				}
+				else
+				{
+					snprintf(number, sizeof(number), "\",\"cat\":\"emit\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%.3f",
+						record.thread, (record.begin - origin) / scale);
+					result += number;
+					snprintf(number, sizeof(number), ",\"args\":{\"count\":%llu}}", static_cast<unsigned long long>(record.count));
+					result += number;
+				}
+			}
+			result += "\n]}\n";
+			return result;
+		}
+		// forgets the records written so far and the rings of threads which exited, names stay
+		static void Clear()
+		{
+			auto&& tracer = Instance();
+			std::lock_guard<std::mutex> l(tracer.lock_);
+			tracer.rings_.erase(std::remove_if(tracer.rings_.begin(), tracer.rings_.end(),
+				[](const std::shared_ptr<Ring>& ring) { return 1 == ring.use_count(); }), tracer.rings_.end());
+			for (auto&& ring : tracer.rings_)
+			{
+				for (auto&& entry : ring->entries_)
+					entry.seq.store(0, std::memory_order_relaxed);
+			}
+		}
+	};
+	/*
+	Policy::Metrics, writes each emission and each slot call with its duration to the Tracer while Tracer::Enabled().
+	signals have no name here, they and their slots are named by address: "signal@0x..", "slot@0x.."
+	*/
+	struct TraceMetrics
+	{
+		struct SignalCounters
+		{
+			std::atomic<uint32_t> id{ 0 };// of the name, see Tracer::Id
+		};
+		struct ConnectionCounters
+		{
+			std::atomic<uint32_t> id{ 0 };
+		};
+		typedef uint64_t Tick;
+		static std::string NameOf(const char* kind, const void* p)
+		{
+			char name[48];
+			snprintf(name, sizeof(name), "%s@%p", kind, p);
+			return name;
+		}
+		template<typename Signal>
+		static void Emitted(SignalCounters& counters, Signal& signal, uint64_t count = 1)
+		{
+			if (!Tracer::Enabled())
+				return;
+			auto now = Tracer::Now();
+			Tracer::Write(Tracer::EmitRecord, Tracer::Id(counters.id, [&]{ return NameOf("signal", &signal); }), 0, now, now, count);
+		}
+		static Tick Start() { return Tracer::Enabled() ? Tracer::Now() : 0; }
+		template<typename Connection>
+		static void Invoked(ConnectionCounters& counters, Tick start, Connection& conn)
+		{
+			if (0 == start)
+				return;
+			auto end = Tracer::Now();
+			Tracer::Write(Tracer::SlotRecord, 0, Tracer::Id(counters.id, [&]{ return NameOf("slot", &conn); }), start, end);
+		}
+		static void Read(const SignalCounters&, SignalMetrics&) {}
+		static void Read(const ConnectionCounters&, SlotMetrics&) {}
+	};
+
+	/*
+	combiners, picked by Policy::Combiner, fold the results of the slots of one emission into what the emission returns.
+	one is made for each emission, gets the result of each slot through operator(), which returns false to stop the emission,
+	and Result() is returned. queued slots, ConnectBatch slots and EmitBatch have no say in it. write your own the same way
+	*/
+	// drops the results, the emission returns void
+	template<typename R>
+	struct DiscardResults
+	{
+		typedef void ResultType;
+		template<typename T>
+		bool operator()(T&&) { return true; }
+		void Result() {}
+	};
+	// the result of the last slot, R() without slots
+	template<typename R>
+	class LastResult
+	{
+	public:
+		typedef typename std::decay<R>::type ResultType;
+	private:
+		ResultType result_ = ResultType();
+	public:
+		template<typename T>
+		bool operator()(T&& value)
+		{
+			result_ = std::forward<T>(value);
+			return true;
+		}
+		ResultType Result() { return std::move(result_); }
+	};
+	// the first result which converts to true, the later slots are not called
+	template<typename R>
+	class FirstNonNull
+	{
+	public:
+		typedef typename std::decay<R>::type ResultType;
+	private:
+		ResultType result_ = ResultType();
+	public:
+		template<typename T>
+		bool operator()(T&& value)
+		{
+			if (!value)
+				return true;
+			result_ = std::forward<T>(value);
+			return false;
+		}
+		ResultType Result() { return std::move(result_); }
+	};
+	// a veto chain: false as soon as a slot returns false, the later slots are not called. true without slots
+	template<typename R>
+	class AllTrue
+	{
+		bool result_ = true;
+	public:
+		typedef bool ResultType;
+		template<typename T>
+		bool operator()(T&& value)
+		{
+			result_ = static_cast<bool>(value);
+			return result_;
+		}
+		bool Result() { return result_; }
+	};
+	// the sum of the results, R() without slots
+	template<typename R>
+	class Sum
+	{
+	public:
+		typedef typename std::decay<R>::type ResultType;
+	private:
+		ResultType result_ = ResultType();
+	public:
+		template<typename T>
+		bool operator()(T&& value)
+		{
+			result_ += std::forward<T>(value);
+			return true;
+		}
+		ResultType Result() { return std::move(result_); }
+	};
+	// the greatest result, R() without slots
+	template<typename R>
+	class Max
+	{
+	public:
+		typedef typename std::decay<R>::type ResultType;
+	private:
+		ResultType result_ = ResultType();
+		bool seen_ = false;
+	public:
+		template<typename T>
+		bool operator()(T&& value)
+		{
+			if (!seen_ || result_ < value)
+				result_ = std::forward<T>(value);
+			seen_ = true;
+			return true;
+		}
+		ResultType Result() { return std::move(result_); }
+	};
 
-namespace nsSigslot
-{
-	class ObjectBase
+	// compile-time options of a Signal, derive from it and override what you need
+	struct DefaultPolicy
 	{
-	protected:
-		std::atomic<bool> enable_ = true;
-		std::function<void(void*)> deleter_;// we need to clear this before releasing a weak pointer
+		typedef LockedDispatch Dispatch;
+		// what a connection stores its callable in, InlineFunction<Sig, Size> avoids the allocations of std::function
+		template<typename Sig>
+		using Slot = std::function<Sig>;
+		// NoMetrics, CollectMetrics or TraceMetrics
+		typedef NoMetrics Metrics;
+		// what an emission does with the results of the slots, see DiscardResults
+		template<typename R>
+		using Combiner = DiscardResults<R>;
+		// disconnected slots are left behind as tombstones, erased in one pass once they are 1/CompactRatio of the slot list
+		static const size_t CompactRatio = 4;
+		// EmitParallel hands each thread at least this many slots at once, fewer than two such chunks run on the emitting thread
+		static const size_t ParallelGrain = 4;
+		// where signals, connections and their slot lists get their memory, e.g. std::pmr::polymorphic_allocator to put them in an
+		// arena. a stateful one is given to the constructor of the Signal, made from Allocator<char>
+		template<typename T>
+		using Allocator = std::allocator<T>;
+	};
+
+	/*
+	contiguous storage handing out stable keys, Find is O(1) and iteration walks a dense array.
+	elements are kept sorted by the group given to Insert, each group being one contiguous range;
+	Insert and Erase swap one element per group after the one they touch, so they are O(1) with a single group.
+	the order inside a group is not preserved
+	*/
+	template<typename T, typename Alloc = std::allocator<T>>
+	class SlotMap
+	{
+	public:
+		typedef SlotKey Key;
+	private:
+		struct Slot
+		{
+			uint32_t dense;// position in items_ when used, next free slot otherwise
+			uint32_t generation;
+		};
+		struct Group
+		{
+			int id;
+			uint32_t end;// the group is items_[previous group's end, end)
+		};
+		template<typename U>
+		using Vector = std::vector<U, typename std::allocator_traits<Alloc>::template rebind_alloc<U>>;
+		static const uint32_t npos = 0xffffffff;
+		Vector<T> items_;
+		Vector<uint32_t> owners_;// items_[i] is referenced by slots_[owners_[i]]
+		Vector<Slot> slots_;
+		Vector<Group> groups_;// sorted by id, never empty ones
+		uint32_t free_ = npos;
+
+		uint32_t Begin(size_t group) const { return 0 == group ? 0 : groups_[group - 1].end; }
+		void Swap(uint32_t a, uint32_t b)
+		{
+			if (a == b)
+				return;
+			std::swap(items_[a], items_[b]);
+			std::swap(owners_[a], owners_[b]);
+			slots_[owners_[a]].dense = a;
+			slots_[owners_[b]].dense = b;
+		}
+	public:
+		explicit SlotMap(const Alloc& alloc = Alloc()) :
+			items_(alloc), owners_(alloc), slots_(alloc), groups_(alloc)
+		{}
+		Key Insert(T item, int group = 0)
+		{
+			auto index = free_;
+			if (npos == index)
+			{
+				index = static_cast<uint32_t>(slots_.size());
+				slots_.push_back(Slot{ 0, 0 });
+			}
+			else
+			{
+				free_ = slots_[index].dense;
+			}
+			auto dense = static_cast<uint32_t>(items_.size());
+			slots_[index].dense = dense;
+			items_.push_back(std::move(item));
+			owners_.push_back(index);
+
+			auto g = std::lower_bound(groups_.begin(), groups_.end(), group, [](const Group& l, int r) { return l.id < r; }) - groups_.begin();
+			if (static_cast<size_t>(g) == groups_.size() || groups_[g].id != group)
+				groups_.insert(groups_.begin() + g, Group{ group, Begin(g) });
+			// walk the new element down to the end of its group, the first element of each later group moves to that group's end
+			for (auto h = groups_.size() - 1; h > static_cast<size_t>(g); --h)
+			{
+				auto begin = Begin(h);
+				Swap(dense, begin);
+				dense = begin;
+				++groups_[h].end;
+			}
+			++groups_[g].end;
+			return Key{ index, slots_[index].generation };
+		}
+		// whether inserting into group moves elements, i.e. a later group has some
+		bool Moves(int group) const
+		{
+			return !groups_.empty() && groups_.back().id > group;
+		}
+		T* Find(Key key)
+		{
+			if (key.index >= slots_.size() || slots_[key.index].generation != key.generation)
+				return nullptr;
+			return &items_[slots_[key.index].dense];
+		}
+		bool Erase(Key key)
+		{
+			if (nullptr == Find(key))
+				return false;
+
+			auto&& slot = slots_[key.index];
+			auto dense = slot.dense;
+			auto g = std::upper_bound(groups_.begin(), groups_.end(), dense, [](uint32_t l, const Group& r) { return l < r.end; }) - groups_.begin();
+			// walk the hole up to the back, the last element of each group fills it and moves the hole to that group's end
+			for (auto h = static_cast<size_t>(g); h < groups_.size(); ++h)
+			{
+				auto last = --groups_[h].end;
+				Swap(dense, last);
+				dense = last;
+			}
+			if (Begin(g) == groups_[g].end)
+				groups_.erase(groups_.begin() + g);
+			items_.pop_back();
+			owners_.pop_back();
+
+			++slot.generation;
+			slot.dense = free_;
+			free_ = key.index;
+			return true;
+		}
+		// erase the elements pred holds for in a single pass, keeping the order of the others. returns how many went
+		template<typename Pred>
+		size_t EraseIf(Pred pred)
+		{
+			uint32_t kept = 0;
+			uint32_t i = 0;
+			for (auto&& group : groups_)
+			{
+				for (; i < group.end; ++i)
+				{
+					auto&& slot = slots_[owners_[i]];
+					if (pred(items_[i]))
+					{
+						++slot.generation;
+						slot.dense = free_;
+						free_ = owners_[i];
+						continue;
+					}
+					if (kept != i)
+					{
+						items_[kept] = std::move(items_[i]);
+						owners_[kept] = owners_[i];
+					}
+					slot.dense = kept++;
+				}
+				group.end = kept;
+			}
+			auto erased = items_.size() - kept;
+			items_.erase(items_.begin() + kept, items_.end());
+			owners_.resize(kept);
+
+			// drop the groups left empty
+			uint32_t begin = 0;
+			size_t used = 0;
+			for (auto&& group : groups_)
+			{
+				if (group.end != begin)
+					groups_[used++] = group;
+				begin = group.end;
+			}
+			groups_.resize(used);
+			return erased;
+		}
+		void Clear()
+		{
+			items_.clear();
+			owners_.clear();
+			slots_.clear();
+			groups_.clear();
+			free_ = npos;
+		}
+		size_t Size() const { return items_.size(); }
+		// the bytes of the arrays, not counting what the elements allocate
+		size_t MemoryUsage() const
+		{
+			return items_.capacity() * sizeof(T) + owners_.capacity() * sizeof(uint32_t) + slots_.capacity() * sizeof(Slot) + groups_.capacity() * sizeof(Group);
+		}
+		T& operator[](size_t i) { return items_[i]; }
+		typename Vector<T>::iterator begin() { return items_.begin(); }
+		typename Vector<T>::iterator end() { return items_.end(); }
+	};
+
+	// a std::function replacement keeping the callable inside the object, it never allocates.
+	// storing a callable bigger than Size bytes is a compile-time error
+	template<typename Signature, size_t Size = 32>
+	class InlineFunction;
+
+	template<typename R, typename ...Args, size_t Size>
+	class InlineFunction<R(Args...), Size>
+	{
+		enum Operation { Copy, Move, Destroy };
+		typedef R(*Invoker)(void*, Args&&...);
+		typedef void(*Manager)(Operation, void*, void*);
+
+		alignas(std::max_align_t) mutable unsigned char storage_[Size];// mutable, like the target of a std::function
+		Invoker invoke_ = nullptr;
+		Manager manage_ = nullptr;
+
+		template<typename F>
+		static R Invoke(void* f, Args&&... args)
+		{
+			return (*static_cast<F*>(f))(std::forward<Args>(args)...);
+		}
+		template<typename F>
+		static void Manage(Operation op, void* dst, void* src)
+		{
+			switch (op)
+			{
+			case Copy:
+				new (dst) F(*static_cast<const F*>(src));
+				break;
+			case Move:
+				new (dst) F(std::move(*static_cast<F*>(src)));
+				break;
+			case Destroy:
+				static_cast<F*>(dst)->~F();
+				break;
+			}
+		}
+		void Assign(Operation op, const InlineFunction& other)
+		{
+			if (other.manage_)
+				other.manage_(op, storage_, other.storage_);
+			invoke_ = other.invoke_;
+			manage_ = other.manage_;
+		}
+		void Reset()
+		{
+			if (manage_)
+				manage_(Destroy, storage_, nullptr);
+			invoke_ = nullptr;
+			manage_ = nullptr;
+		}
 	public:
-		virtual ~ObjectBase(){}
-		virtual void OnFinal(){deleter_ = nullptr;}
-		void Enable(bool enable = true){ enable_ = enable; }
-		bool Enabled(){ return enable_; }
+		InlineFunction() {}
+		InlineFunction(std::nullptr_t) {}
+		template<typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, InlineFunction>::value>::type>
+		InlineFunction(F&& f)
+		{
+			typedef typename std::decay<F>::type Functor;
+			static_assert(sizeof(Functor) <= Size, "the callable does not fit, increase the Size of InlineFunction");
+			static_assert(alignof(Functor) <= alignof(std::max_align_t), "the callable is over-aligned for InlineFunction");
+			new (storage_) Functor(std::forward<F>(f));
+			invoke_ = &Invoke<Functor>;
+			manage_ = &Manage<Functor>;
+		}
+		InlineFunction(const InlineFunction& other) { Assign(Copy, other); }
+		InlineFunction(InlineFunction&& other) { Assign(Move, other); }
+		~InlineFunction() { Reset(); }
+		InlineFunction& operator=(const InlineFunction& other)
+		{
+			if (this != &other)
+			{
+				Reset();
+				Assign(Copy, other);
+			}
+			return *this;
+		}
+		InlineFunction& operator=(InlineFunction&& other)
+		{
+			if (this != &other)
+			{
+				Reset();
+				Assign(Move, other);
+			}
+			return *this;
+		}
+		explicit operator bool() const { return nullptr != invoke_; }
+		R operator()(Args... args) const
+		{
+			if (nullptr == invoke_)
+				throw std::bad_function_call();
+			return invoke_(storage_, std::forward<Args>(args)...);
+		}
 	};
 
+	template<size_t ...I>
+	struct IndexSequence {};
+	template<size_t N, size_t ...I>
+	struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, I...> {};
+	template<size_t ...I>
+	struct MakeIndexSequence<0, I...> { typedef IndexSequence<I...> type; };
+
+	template<typename ...Args>
+	struct BatchItemOf { typedef std::tuple<typename std::decay<Args>::type...> type; };
+	template<typename Arg>
+	struct BatchItemOf<Arg> { typedef typename std::decay<Arg>::type type; };
+
 	template<typename Signature>
+	struct SignatureTraits;
+	template<typename R, typename ...Args>
+	struct SignatureTraits<R(Args...)>
+	{
+		typedef R Result;
+		typedef std::tuple<Args...> Arguments;
+		typedef std::tuple<typename std::decay<Args>::type...> Values;// what a queued call keeps of the arguments
+		typedef typename BatchItemOf<Args...>::type BatchItem;// an element of EmitBatch: the argument itself, or a tuple of them
+		static const size_t Arity = sizeof...(Args);
+	};
+
+	/*
+	an emission hands its arguments to the last slot as they came, moving rvalues in; the other slots get arguments
+	as lvalues, except for Arg&& parameters, which see the same object as an rvalue and leave it to the slot whether to move
+	from it. a move-only parameter taken by value would be moved out by the first slot, so it doesn't compile: declare it
+	Arg&& or const Arg&
+	*/
+	template<typename Arg>
+	struct ShareAsRvalue :
+		std::is_rvalue_reference<Arg>
+	{};
+	template<typename Arg, typename Param>
+	auto ShareArgument(Param& param) -> typename std::conditional<ShareAsRvalue<Arg>::value, Param&&, Param&>::type
+	{
+		static_assert(std::is_reference<Arg>::value || std::is_copy_constructible<typename std::decay<Arg>::type>::value,
+			"the first slot would move a move-only parameter taken by value away from the others, declare it Arg&& or const Arg&");
+		return static_cast<typename std::conditional<ShareAsRvalue<Arg>::value, Param&&, Param&>::type>(param);
+	}
+	// whether an emission must hand some argument of Signature to its slots as an rvalue, see ShareAsRvalue
+	template<typename Arguments>
+	struct SharesAsRvalue;
+	template<>
+	struct SharesAsRvalue<std::tuple<>> : std::false_type {};
+	template<typename Arg, typename ...Rest>
+	struct SharesAsRvalue<std::tuple<Arg, Rest...>> :
+		std::integral_constant<bool, ShareAsRvalue<Arg>::value || SharesAsRvalue<std::tuple<Rest...>>::value>
+	{};
+	// how a queued call hands its copy of an argument to the slot: moved in, unless the parameter is an lvalue reference
+	template<typename Arg, typename Value>
+	auto GiveArgument(Value& value) -> typename std::conditional<std::is_lvalue_reference<Arg>::value, Value&, Value&&>::type
+	{
+		return static_cast<typename std::conditional<std::is_lvalue_reference<Arg>::value, Value&, Value&&>::type>(value);
+	}
+
+	// a unit of work posted to an Executor
+	class Task
+	{
+		friend class MpscQueue;
+		std::atomic<Task*> next_{ nullptr };// the link of the MpscQueue it waits in
+	public:
+		virtual ~Task(){}
+		virtual void Run() = 0;
+	};
+
+	// runs the slots of queued signals and connections, implement it to hand them to your own event loop
+	class Executor
+	{
+	public:
+		virtual ~Executor(){}
+		virtual void Post(std::unique_ptr<Task> task) = 0;
+	};
+
+	// runs tasks right away on the emitting thread, e.g. to keep one connection of a queued signal synchronous
+	class InlineExecutor :
+		public Executor
+	{
+	public:
+		void Post(std::unique_ptr<Task> task) override { task->Run(); }
+	};
+
+#ifdef SIGSLOT_COROUTINES
+	// resumes a coroutine waiting in Signal::Next on the executor it asked for
+	class ResumeTask :
+		public Task
+	{
+		std::coroutine_handle<> handle_;
+	public:
+		explicit ResumeTask(std::coroutine_handle<> handle) : handle_(handle) {}
+		void Run() override { handle_.resume(); }
+	};
+#endif
+
+	// bounded lock-free multi-producer multi-consumer queue (Dmitry Vyukov's design), capacity is rounded up to a power of 2
+	template<typename T>
+	class MpmcQueue
+	{
+		struct Cell
+		{
+			std::atomic<size_t> sequence;
+			T data;
+		};
+		std::vector<Cell> cells_;
+		size_t mask_;
+		char pad0_[64];// keep producers and consumers off each other's cache line
+		std::atomic<size_t> enqueue_pos_{ 0 };
+		char pad1_[64];
+		std::atomic<size_t> dequeue_pos_{ 0 };
+		char pad2_[64];
+
+		static size_t RoundUp(size_t n)
+		{
+			size_t result = 2;
+			while (result < n)
+				result <<= 1;
+			return result;
+		}
+	public:
+		explicit MpmcQueue(size_t capacity) :
+			cells_(RoundUp(capacity)), mask_(cells_.size() - 1)
+		{
+			for (size_t i = 0; i < cells_.size(); ++i)
+				cells_[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		bool TryPush(T value)
+		{
+			auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				auto&& cell = cells_[pos & mask_];
+				auto seq = cell.sequence.load(std::memory_order_acquire);
+				auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+				if (0 == diff)
+				{
+					if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						cell.data = std::move(value);
+						cell.sequence.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (diff < 0)
+					return false;// full
+				else
+					pos = enqueue_pos_.load(std::memory_order_relaxed);
+			}
+		}
+		bool TryPop(T& value)
+		{
+			auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				auto&& cell = cells_[pos & mask_];
+				auto seq = cell.sequence.load(std::memory_order_acquire);
+				auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+				if (0 == diff)
+				{
+					if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						value = std::move(cell.data);
+						cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (diff < 0)
+					return false;// empty
+				else
+					pos = dequeue_pos_.load(std::memory_order_relaxed);
+			}
+		}
+	};
+
+	/*
+	the built-in Executor: worker threads sharing one lock-free queue.
+	producers only touch the queue, and signal a condition variable when a worker is asleep;
+	a worker which wakes up keeps draining up to batch tasks before it checks whether to sleep again.
+	Post() yields while the queue is full, the destructor runs what is still queued before joining
+	*/
+	class ThreadPool :
+		public Executor
+	{
+		MpmcQueue<Task*> queue_;
+		size_t batch_;
+		std::atomic<bool> stop_{ false };
+		std::atomic<int> sleepers_{ 0 };
+		std::mutex wake_lock_;
+		std::condition_variable wake_;
+		std::vector<std::thread> threads_;
+
+		// runs up to batch_ tasks, returns how many there were
+		size_t Drain()
+		{
+			size_t count = 0;
+			Task* task = nullptr;
+			while (count < batch_ && queue_.TryPop(task))
+			{
+				std::unique_ptr<Task> owned(task);
+				owned->Run();
+				++count;
+			}
+			return count;
+		}
+		void Work()
+		{
+			for (;;)
+			{
+				if (Drain())
+					continue;
+
+				std::unique_lock<std::mutex> l(wake_lock_);
+				sleepers_.fetch_add(1);
+				Task* task = nullptr;
+				if (queue_.TryPop(task))
+				{// raced with a Post which didn't see us sleeping
+					sleepers_.fetch_sub(1);
+					l.unlock();
+					std::unique_ptr<Task> owned(task);
+					owned->Run();
+					continue;
+				}
+				if (stop_)
+				{
+					sleepers_.fetch_sub(1);
+					return;
+				}
+				wake_.wait(l);
+				sleepers_.fetch_sub(1);
+			}
+		}
+	public:
+		explicit ThreadPool(size_t threads = std::thread::hardware_concurrency(), size_t capacity = 65536, size_t batch = 64) :
+			queue_(capacity), batch_(batch ? batch : 1)
+		{
+			if (0 == threads)
+				threads = 1;
+			for (size_t i = 0; i < threads; ++i)
+				threads_.push_back(std::thread([this]{ Work(); }));
+		}
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> l(wake_lock_);
+				stop_ = true;
+			}
+			wake_.notify_all();
+			for (auto&& thread : threads_)
+				thread.join();
+		}
+		size_t Size() const { return threads_.size(); }
+		void Post(std::unique_ptr<Task> task) override
+		{
+			auto p = task.release();
+			while (!queue_.TryPush(p))
+				std::this_thread::yield();
+
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (sleepers_.load())
+			{
+				std::lock_guard<std::mutex> l(wake_lock_);
+				wake_.notify_one();
+			}
+		}
+	};
+	/*
+	calls f(begin, end) over [0, count) in chunks of grain, on the calling thread and on up to helpers tasks posted to executor,
+	whoever is free claims the next chunk; returns once all of them ran. a helper which starts late finds nothing left and
+	never touches f, so nothing waits for it and the caller may be a thread of executor itself
+	*/
+	class ParallelFor
+	{
+		struct State
+		{
+			void(*run_)(void*, size_t, size_t);
+			void* f_;
+			size_t count_;
+			size_t grain_;
+			std::atomic<size_t> next_{ 0 };// the first index not claimed yet
+			std::atomic<size_t> done_{ 0 };// how many indexes ran
+			std::mutex lock_;
+			std::condition_variable finished_;
+
+			State(void(*run)(void*, size_t, size_t), void* f, size_t count, size_t grain) : run_(run), f_(f), count_(count), grain_(grain) {}
+			void Work()
+			{
+				for (;;)
+				{
+					auto begin = next_.fetch_add(grain_, std::memory_order_relaxed);
+					if (begin >= count_)
+						return;
+					auto end = std::min(begin + grain_, count_);
+					run_(f_, begin, end);
+					if (done_.fetch_add(end - begin, std::memory_order_acq_rel) + (end - begin) == count_)
+					{
+						std::lock_guard<std::mutex> l(lock_);
+						finished_.notify_all();
+					}
+				}
+			}
+		};
+		class Helper :
+			public Task
+		{
+			std::shared_ptr<State> state_;
+		public:
+			explicit Helper(std::shared_ptr<State> state) : state_(std::move(state)) {}
+			void Run() override { state_->Work(); }
+		};
+		template<typename F>
+		static void Call(void* f, size_t begin, size_t end)
+		{
+			(*static_cast<F*>(f))(begin, end);
+		}
+	public:
+		template<typename F>
+		static void Run(Executor& executor, size_t helpers, size_t count, size_t grain, F&& f)
+		{
+			if (0 == grain)
+				grain = 1;
+			if (count <= grain || 0 == helpers)
+			{
+				if (count)
+					f(size_t(0), count);
+				return;
+			}
+			typedef typename std::remove_reference<F>::type Functor;
+			auto state = std::make_shared<State>(&Call<Functor>, static_cast<void*>(std::addressof(f)), count, grain);
+			helpers = std::min(helpers, (count - 1) / grain);// the caller takes a chunk too
+			for (size_t i = 0; i < helpers; ++i)
+				executor.Post(std::unique_ptr<Task>(new Helper(state)));
+			state->Work();
+
+			std::unique_lock<std::mutex> l(state->lock_);
+			state->finished_.wait(l, [&]{ return state->done_.load(std::memory_order_acquire) == count; });
+		}
+	};
+
+
+	// unbounded lock-free queue of tasks linked through themselves (Dmitry Vyukov's intrusive design), any thread pushes and one pops
+	class MpscQueue
+	{
+		struct Stub :
+			public Task
+		{
+			void Run() override {}
+		};
+		Stub stub_;
+		std::atomic<Task*> head_;// the last pushed
+		Task* tail_;// the next to pop, only touched by the consumer
+	public:
+		MpscQueue() : head_(&stub_), tail_(&stub_) {}
+		MpscQueue(const MpscQueue&) = delete;
+		MpscQueue& operator=(const MpscQueue&) = delete;
+		~MpscQueue()
+		{
+			while (auto task = Pop())
+				delete task;
+		}
+		// one exchange, the queue owns task until it is popped
+		void Push(Task* task)
+		{
+			task->next_.store(nullptr, std::memory_order_relaxed);
+			auto prev = head_.exchange(task, std::memory_order_acq_rel);
+			prev->next_.store(task, std::memory_order_release);
+		}
+		// nullptr when empty, or when the next task is still being pushed
+		Task* Pop()
+		{
+			auto tail = tail_;
+			auto next = tail->next_.load(std::memory_order_acquire);
+			if (&stub_ == tail)
+			{
+				if (nullptr == next)
+					return nullptr;
+				tail_ = next;
+				tail = next;
+				next = next->next_.load(std::memory_order_acquire);
+			}
+			if (nullptr != next)
+			{
+				tail_ = next;
+				return tail;
+			}
+			if (tail != head_.load(std::memory_order_acquire))
+				return nullptr;
+			// tail is the last one, put the stub behind it so it can leave
+			Push(&stub_);
+			next = tail->next_.load(std::memory_order_acquire);
+			if (nullptr == next)
+				return nullptr;
+			tail_ = next;
+			return tail;
+		}
+	};
+
+	/*
+	the Executor of a thread, its tasks run when the thread calls PumpEvents(). made for each thread on first use by Current(),
+	see Signal::ConnectAffine. posting from another thread is one push to a lock-free queue, the owner thread runs the task right away.
+	once the thread exits the mailbox drops what is posted to it, it goes away with the last connection using it
+	*/
+	class Mailbox :
+		public Executor
+	{
+		MpscQueue queue_;
+		std::thread::id owner_ = std::this_thread::get_id();
+		std::atomic<bool> closed_{ false };
+
+		// closes the mailbox of a thread when it exits
+		struct Holder
+		{
+			std::shared_ptr<Mailbox> mailbox_;
+			~Holder()
+			{
+				if (!mailbox_)
+					return;
+				mailbox_->closed_ = true;
+				while (auto task = mailbox_->queue_.Pop())
+					delete task;
+			}
+		};
+		static Holder& Here()
+		{
+			static thread_local Holder holder;
+			if (!holder.mailbox_)
+				holder.mailbox_ = std::make_shared<Mailbox>();
+			return holder;
+		}
+	public:
+		// the mailbox of the calling thread
+		static std::shared_ptr<Mailbox> Current() { return Here().mailbox_; }
+		void Post(std::unique_ptr<Task> task) override
+		{
+			if (std::this_thread::get_id() == owner_)
+				task->Run();
+			else if (!closed_.load(std::memory_order_relaxed))
+				queue_.Push(task.release());
+		}
+		// runs up to max of the tasks posted from other threads, must be called by the owner thread. returns how many ran
+		size_t Pump(size_t max = static_cast<size_t>(-1))
+		{
+			size_t count = 0;
+			while (count < max)
+			{
+				std::unique_ptr<Task> task(queue_.Pop());
+				if (!task)
+					break;
+				task->Run();
+				++count;
+			}
+			return count;
+		}
+		friend size_t PumpEvents(size_t max);
+	};
+
+	// runs the slots other threads posted to the calling thread's Mailbox, returns how many ran
+	inline size_t PumpEvents(size_t max = static_cast<size_t>(-1))
+	{
+		return Mailbox::Here().mailbox_->Pump(max);
+	}
+
+	template<typename Signature, typename Slot = std::function<Signature>, typename Access = AtomicAccess, typename Metrics = NoMetrics>
 	class Connection:
-		public ObjectBase
+		public BasicObjectBase<Access>,
+		private Metrics::ConnectionCounters// empty unless metrics are collected
 	{
-		template<typename Signature, typename Mutex>
+		template<typename, typename, typename>
 		friend class Signal;
-		std::function<Signature> slot_;
+		template<typename>
+		friend class ScopedConnection;
+		typedef std::function<void(const typename SignatureTraits<Signature>::BatchItem*, size_t)> BatchSlot;
+		Slot slot_;
+		Executor* executor_ = nullptr;// overrides the signal's executor when set
+		std::shared_ptr<Mailbox> mailbox_;// the thread mailbox of ConnectAffine, executor_ points to it
+		int group_ = 0;// where the signal keeps and calls it, lower groups first
+		std::unique_ptr<BatchSlot> batch_slot_;// set by ConnectBatch, slot_ then forwards single emissions to it
+		typename Access::template Atomic<bool> closed_{ false };// set when its ScopedConnection goes away, the signal still holds it
 
+		typename Metrics::ConnectionCounters& Counters() { return *this; }
+		// the end of a scoped connection: no further calls start, the signal lets go of it when it compacts
+		void Close()
+		{
+			closed_ = true;
+			auto owner = this->owner_;
+			this->owner_ = nullptr;
+			if (owner)
+				owner->Detach(this, this->key_);
+		}
+		// calls the slot and hands its result to combiner, false stops the emission
+		template <typename Combiner, typename ...Params>
+		bool Call(Combiner& combiner, Params&&... params)
+		{
+			if (!this->Enabled())
+				return true;
+			auto start = Metrics::Start();
+			auto more = Fold(combiner, std::is_void<typename SignatureTraits<Signature>::Result>(), std::forward<Params>(params)...);
+			Metrics::Invoked(Counters(), start, *this);
+			return more;
+		}
+		template <typename Combiner, typename ...Params>
+		bool Fold(Combiner& combiner, std::false_type, Params&&... params)
+		{
+			// a batch slot returns nothing, the Result() its thunk makes up must not reach the combiner
+			if (batch_slot_)
+			{
+				slot_(std::forward<Params>(params)...);
+				return true;
+			}
+			return combiner(slot_(std::forward<Params>(params)...));
+		}
+		template <typename Combiner, typename ...Params>
+		bool Fold(Combiner&, std::true_type, Params&&... params)
+		{
+			slot_(std::forward<Params>(params)...);
+			return true;
+		}
 		template <typename ...Params>
 		void operator()(Params&&... params)
 		{
-			if (!Enabled())
-				return;
-			slot_(params...);
+			DiscardResults<typename SignatureTraits<Signature>::Result> discard;
+			Call(discard, std::forward<Params>(params)...);
 		}
 		template <typename ...Params>
 		void Emit(Params&&... params)
 		{
-			operator()(params...);
+			operator()(std::forward<Params>(params)...);
+		}
+	};
+
+	/*
+	the only handle of a connection made by Signal::ConnectScoped, it disconnects when it goes away and can be moved, not copied.
+	the signal owns the connection meanwhile, so emitting checks a flag of it instead of locking a weak reference
+	*/
+	template<typename ConnectionPtr>
+	class ScopedConnection
+	{
+		ConnectionPtr conn_;
+	public:
+		ScopedConnection() {}
+		explicit ScopedConnection(ConnectionPtr conn) : conn_(std::move(conn)) {}
+		ScopedConnection(ScopedConnection&& other) : conn_(std::move(other.conn_)) {}
+		ScopedConnection& operator=(ScopedConnection&& other)
+		{
+			if (this != &other)
+			{
+				Disconnect();
+				conn_ = std::move(other.conn_);
+			}
+			return *this;
+		}
+		ScopedConnection(const ScopedConnection&) = delete;
+		ScopedConnection& operator=(const ScopedConnection&) = delete;
+		~ScopedConnection(){ Disconnect(); }
+		void Disconnect()
+		{
+			if (conn_)
+			{
+				conn_->Close();
+				conn_.reset();
+			}
 		}
+		typename ConnectionPtr::element_type* operator->() const { return conn_.get(); }
+		explicit operator bool() const { return static_cast<bool>(conn_); }
 	};
 
-	template<typename Signature, typename Mutex = std::recursive_mutex>
+	// Threading : a mutex type, MultiThreaded<Mutex> or SingleThreaded
+	template<typename Signature, typename Threading = std::recursive_mutex, typename Policy = DefaultPolicy>
 	class Signal :
-		public ObjectBase
+		public BasicObjectBase<typename ThreadingOf<Threading>::type::Access>,
+		private BasicOwnerBase<typename ThreadingOf<Threading>::type::Access>,
+		private Policy::Metrics::SignalCounters// empty unless metrics are collected
 	{
-		typedef std::pair<void*, std::weak_ptr<Connection<Signature>>> WeakConnection;
-		Mutex lock_;
-		std::list<WeakConnection> conns_;
 	public:
+		typedef typename ThreadingOf<Threading>::type ThreadingModel;
+		typedef typename ThreadingModel::Access Access;
+		typedef typename Policy::Metrics Metrics;
+		typedef typename Policy::template Slot<Signature> SlotType;
+		typedef Connection<Signature, SlotType, Access, Metrics> ConnectionType;
+		typedef typename Policy::template Combiner<typename SignatureTraits<Signature>::Result> CombinerType;
+		typedef typename CombinerType::ResultType ResultType;// what an emission returns
+		typedef typename Access::template SharedPtr<ConnectionType> ConnectionPtr;// std::shared_ptr unless SingleThreaded
+		typedef typename SignatureTraits<Signature>::BatchItem BatchItem;
+		typedef typename ConnectionType::BatchSlot BatchSlot;
+		typedef typename Policy::template Allocator<char> AllocatorType;
+		typedef nsSigslot::ScopedConnection<ConnectionPtr> ScopedConnection;// what ConnectScoped returns
+#ifdef SIGSLOT_COROUTINES
+		class NextEmission;// what Next() returns
+#endif
+	private:
+		typedef typename Access::template WeakPtr<ConnectionType> WeakConnection;
+		// an element of the slot list, a weak reference to a shared connection or the reference of a scoped one
+		struct Entry
+		{
+			WeakConnection weak_;
+			ConnectionPtr scoped_;
+
+			Entry() {}
+			Entry(const ConnectionPtr& conn, bool scoped) : weak_(scoped ? WeakConnection() : WeakConnection(conn)), scoped_(scoped ? conn : nullptr) {}
+			// the connection while it is alive, locked keeps a shared one alive in the meantime
+			const ConnectionPtr* Lock(ConnectionPtr& locked) const
+			{
+				if (scoped_)
+					return scoped_->closed_.load(std::memory_order_relaxed) ? nullptr : &scoped_;
+				locked = weak_.lock();
+				return locked ? &locked : nullptr;
+			}
+			bool Expired() const { return scoped_ ? scoped_->closed_.load(std::memory_order_relaxed) : weak_.expired(); }
+		};
+		template<typename U>
+		using Vector = std::vector<U, typename std::allocator_traits<AllocatorType>::template rebind_alloc<U>>;
+		// an immutable copy of the slot list, published by SnapshotDispatch. emitters read it in an Access::Epoch section,
+		// the copy it replaces is freed by a later Publish once no emitter can still be reading it
+		struct SnapshotEntries
+		{
+			Vector<Entry> entries_;
+			template<typename Iterator>
+			SnapshotEntries(Iterator first, Iterator last, const AllocatorType& alloc) : entries_(first, last, alloc) {}
+		};
+		typedef typename std::allocator_traits<AllocatorType>::template rebind_alloc<SnapshotEntries> SnapshotAllocator;
+		typedef std::pair<uint64_t, SnapshotEntries*> Retired;// a replaced snapshot and its Epoch::Retire() stamp
+		AllocatorType alloc_;
+		typename ThreadingModel::Lock lock_;
+		SlotMap<Entry, typename std::allocator_traits<AllocatorType>::template rebind_alloc<Entry>> conns_;
+		uint32_t emitting_ = 0;// nesting depth of LockedDispatch emissions, guarded by lock_
+		typename Access::template Atomic<int> tombstones_{ 0 };// expired entries of conns_, counted by Detach and erased by Compact
+		Vector<Entry> pending_connect_;// connected while emitting, placed once it is done so conns_ stays put under the emitters
+		typename Access::template Atomic<SnapshotEntries*> snapshot_{ nullptr };// only used by SnapshotDispatch, stored under lock_
+		Vector<Retired> retired_;// guarded by lock_
+		typename Access::template Atomic<Executor*> executor_{ nullptr };// slots are posted to it instead of being called, when set
+#ifdef SIGSLOT_COROUTINES
+		typename Access::template Atomic<NextEmission*> waiters_{ nullptr };// the coroutines suspended in Next(), changed under lock_
+		NextEmission* last_waiter_ = nullptr;// guarded by lock_
+#endif
+	public:
+		Signal() : Signal(AllocatorType()) {}
+		// alloc : where the connections and the slot list get their memory
+		explicit Signal(const AllocatorType& alloc) :
+			alloc_(alloc), conns_(alloc), pending_connect_(alloc), retired_(alloc)
+		{}
 		~Signal()
 		{
+#ifdef SIGSLOT_COROUTINES
+			NextEmission* waiters = nullptr;
+			{
+				std::lock_guard<decltype(lock_)> l(lock_);
+				waiters = DetachWaiters();
+			}
+			// with no value
+			NextEmission::ResumeAll(waiters, nullptr);
+#endif
 			std::lock_guard<decltype(lock_)> l(lock_);
-			for (auto&& conn : conns_)
+			for (auto&& entry : conns_)
 			{
-				auto locked_conn = conn.second.lock();
-				if (locked_conn)
+				ConnectionPtr locked;
+				auto conn = entry.Lock(locked);
+				if (conn)
 				{// clear the callback
-					locked_conn->OnFinal();
+					(*conn)->OnFinal();
 				}
 			}
+			// no emission can be under way any more
+			auto snapshot = snapshot_.load(std::memory_order_relaxed);
+			if (snapshot)
+				FreeSnapshot(snapshot);
+			for (auto&& item : retired_)
+				FreeSnapshot(item.second);
 		}
 		template <typename ...Params>
-		void operator()(Params&&... params)
+		auto operator()(Params&&... params) -> ResultType
 		{
-			if (!Enabled())
-				return;
-
-			std::lock_guard<decltype(lock_)> l(lock_);
-			auto it = conns_.begin();
-			auto itEnd = conns_.end();
+			CombinerType combiner;
+			if (!this->Enabled())
+				return combiner.Result();
 
-			while (it != itEnd)
+			Metrics::Emitted(Counters(), *this);
+#ifdef SIGSLOT_COROUTINES
+			// the waiters copy the arguments before the last slot may move them away, and are resumed after the slots
+			auto waiters = TakeWaiters(params...);
+#endif
+			ForEach(typename Policy::Dispatch(), [&](const ConnectionPtr& conn, bool last) -> bool
 			{
-				auto itNext = it;
-				++itNext;
+				if (last)
+					return Invoke(conn, combiner, std::forward<Params>(params)...);
+				return InvokeShared(conn, combiner, typename MakeIndexSequence<sizeof...(Params)>::type(), params...);
+			});
+#ifdef SIGSLOT_COROUTINES
+			NextEmission::ResumeAll(waiters, executor_.load(std::memory_order_relaxed));
+#endif
+			return combiner.Result();
+		}
+		/*
+		emit each element of [first, last), an element is the argument itself for single parameter signatures and a std::tuple
+		of the arguments otherwise. the slot list is taken once and each connection locked once, then gets the whole batch
+		before the next one does. Iterator must be a forward iterator, pass pointers to hand batch slots your storage as is
+		*/
+		template <typename Iterator>
+		void EmitBatch(Iterator first, Iterator last)
+		{
+			if (!this->Enabled() || first == last)
+				return;
 
-				auto conn = it->second.lock();
-				if (conn)
-					(*conn)(params...);
-				else
-					conns_.erase(it);
+			Metrics::Emitted(Counters(), *this, std::distance(first, last));
+#ifdef SIGSLOT_COROUTINES
+			// a batch is one emission for Next(), the waiters get its first item
+			auto waiters = TakeWaiters(*first);
+#endif
+			std::vector<BatchItem> copy;// made when a batch slot needs contiguous items we don't have
+			DiscardResults<typename SignatureTraits<Signature>::Result> discard;
+			ForEach(typename Policy::Dispatch(), [&](const ConnectionPtr& conn, bool) -> bool
+			{
+				if (conn->batch_slot_ && nullptr == (conn->executor_ ? conn->executor_ : executor_.load(std::memory_order_relaxed)))
+				{
+					if (conn->Enabled())
+					{
+						auto items = Contiguous(first, last, copy);
+						auto start = Metrics::Start();
+						(*conn->batch_slot_)(items.first, items.second);
+						Metrics::Invoked(conn->Counters(), start, *conn);
+					}
+					return true;
+				}
+				for (auto it = first; it != last; ++it)
+					InvokeItem(conn, discard, *it, std::integral_constant<bool, 1 == SignatureTraits<Signature>::Arity>());
+				return true;
+			});
+#ifdef SIGSLOT_COROUTINES
+			NextEmission::ResumeAll(waiters, executor_.load(std::memory_order_relaxed));
+#endif
+		}
+		/*
+		for many heavy, independent slots: runs them on the threads of pool and the calling thread at once, returning when all ran.
+		the live slots are split in chunks of at least Policy::ParallelGrain, taken by whichever thread is free next, and a small
+		list runs on the calling thread alone. the slots run without the lock of the signal and read the same arguments
+		concurrently, so none may need them as rvalues; their results are dropped, connections with an executor are posted to it
+		*/
+		template <typename ...Params>
+		void EmitParallel(ThreadPool& pool, Params&&... params)
+		{
+			static_assert(!SharesAsRvalue<typename SignatureTraits<Signature>::Arguments>::value, "EmitParallel shares the arguments between threads");
+			static_assert(!std::is_same<Access, PlainAccess>::value, "EmitParallel runs slots on other threads, the reference counts of a SingleThreaded signal are not atomic");
+			if (!this->Enabled())
+				return;
 
-				it = itNext;
+			Metrics::Emitted(Counters(), *this);
+#ifdef SIGSLOT_COROUTINES
+			auto waiters = TakeWaiters(params...);
+#endif
+			std::vector<ConnectionPtr> conns;
+			{
+				std::lock_guard<decltype(lock_)> l(lock_);
+				conns.reserve(conns_.Size());
+				for (auto&& entry : conns_)
+				{
+					ConnectionPtr locked;
+					auto conn = entry.Lock(locked);
+					if (conn)
+						conns.push_back(*conn);
+				}
 			}
+			// about four chunks per thread, so threads which got light slots take more
+			// a copy, since std::max takes references and the policy constant has no definition out of its class
+			const size_t min_grain = Policy::ParallelGrain;
+			auto threads = pool.Size() + 1;
+			auto grain = std::max(min_grain, (conns.size() + threads * 4 - 1) / (threads * 4));
+			ParallelFor::Run(pool, pool.Size(), conns.size(), grain, [&](size_t begin, size_t end)
+			{
+				DiscardResults<typename SignatureTraits<Signature>::Result> discard;
+				for (auto i = begin; i < end; ++i)
+					InvokeShared(conns[i], discard, typename MakeIndexSequence<sizeof...(Params)>::type(), params...);
+			});
+#ifdef SIGSLOT_COROUTINES
+			NextEmission::ResumeAll(waiters, executor_.load(std::memory_order_relaxed));
+#endif
 		}
 		template <typename ...Params>
-		void Emit(Params&&... params)
+		auto Emit(Params&&... params) -> ResultType
 		{
-			operator()(params...);
+			return operator()(std::forward<Params>(params)...);
 		}
-		// save the return value as long as you want to keep the connection
-		auto Connect(std::function<Signature> func) -> std::shared_ptr<Connection<Signature>>
+		// what Policy::Metrics collected for the signal and its live connections, all zero with NoMetrics
+		SignalMetrics ReadMetrics()
 		{
-			auto conn = new Connection<Signature>();
-			conn->slot_ = func;
-
-			auto result = std::shared_ptr<Connection<Signature>>(conn, [](Connection<Signature>* p)
+			SignalMetrics result;
+			Metrics::Read(Counters(), result);
+			std::lock_guard<decltype(lock_)> l(lock_);
+			for (auto&& entry : conns_)
 			{
-				if (p->deleter_)
-					p->deleter_(p);
-				delete p;
-			});
-			ConnectInternal(conn,result);
+				ConnectionPtr locked;
+				auto conn = entry.Lock(locked);
+				if (!conn)
+					continue;
+				auto&& locked_conn = *conn;
+				SlotMetrics slot;
+				Metrics::Read(locked_conn->Counters(), slot);
+				result.slots.push_back(std::move(slot));
+			}
+			return result;
+		}
+		// about the bytes the signal holds: itself, its slot lists and its connections, without what their callables allocate
+		size_t MemoryUsage()
+		{
+			std::lock_guard<decltype(lock_)> l(lock_);
+			size_t result = sizeof(*this) + conns_.MemoryUsage() + pending_connect_.capacity() * sizeof(Entry);
+			auto snapshot = snapshot_.load(std::memory_order_relaxed);
+			if (snapshot)
+				result += sizeof(SnapshotEntries) + snapshot->entries_.capacity() * sizeof(Entry);
+			for (auto&& item : retired_)
+				result += sizeof(SnapshotEntries) + item.second->entries_.capacity() * sizeof(Entry);
+			result += retired_.capacity() * sizeof(Retired);
+			for (auto&& entry : conns_)
+			{
+				ConnectionPtr locked;
+				auto conn = entry.Lock(locked);
+				if (conn)
+					result += sizeof(ConnectionType) + ((*conn)->batch_slot_ ? sizeof(BatchSlot) : 0);
+			}
+			return result;
+		}
+		/*
+		queue the slot invocations of further emissions to executor instead of running them on the emitting thread
+		the arguments are copied, nullptr goes back to synchronous dispatch. executor must outlive the signal
+		*/
+		void SetExecutor(Executor* executor)
+		{
+			executor_ = executor;
+		}
+		// save the return value as long as you want to keep the connection
+		// executor : optional, overrides the signal's executor for this connection
+		auto Connect(SlotType func, Executor* executor = nullptr) -> ConnectionPtr
+		{
+			return Connect(std::move(func), 0, executor);
+		}
+		// group : the slots of lower groups are called first, the order within a group is unspecified. Connect() uses 0
+		auto Connect(SlotType func, int group, Executor* executor = nullptr) -> ConnectionPtr
+		{
+			auto result = MakeConnection(std::move(func), group, executor);
+			ConnectInternal(result);
+			return result;
+		}
+		/*
+		a member function of object, Connect<&Receiver::OnValue>(this) with C++17 and Connect<decltype(&Receiver::OnValue),
+		&Receiver::OnValue>(this) before it. the slot holds the object pointer alone and calls the method directly, no allocation.
+		when Class derives from Trackable, object keeps the connection and disconnects it when it goes away; keep the result otherwise
+		*/
+#if defined(__cpp_nontype_template_parameter_auto) && __cpp_nontype_template_parameter_auto >= 201606L
+		template<auto method, typename Class>
+		auto Connect(Class* object, Executor* executor = nullptr) -> ConnectionPtr
+		{
+			return Connect<decltype(method), method>(object, 0, executor);
+		}
+		template<auto method, typename Class>
+		auto Connect(Class* object, int group, Executor* executor = nullptr) -> ConnectionPtr
+		{
+			return Connect<decltype(method), method>(object, group, executor);
+		}
+#endif
+		template<typename Method, Method method, typename Class>
+		auto Connect(Class* object, Executor* executor = nullptr) -> ConnectionPtr
+		{
+			return Connect<Method, method>(object, 0, executor);
+		}
+		template<typename Method, Method method, typename Class>
+		auto Connect(Class* object, int group, Executor* executor = nullptr) -> ConnectionPtr
+		{
+			auto result = Connect(SlotType(MemberSlot<Method, method, Class>{ object }), group, executor);
+			Track(object, result, std::is_base_of<BasicTrackableBase<Access>, Class>());
+			return result;
+		}
+		// like Connect, but the returned handle is the only one of the connection and can't be shared
+		auto ConnectScoped(SlotType func, Executor* executor = nullptr) -> ScopedConnection
+		{
+			return ConnectScoped(std::move(func), 0, executor);
+		}
+		auto ConnectScoped(SlotType func, int group, Executor* executor = nullptr) -> ScopedConnection
+		{
+			auto result = MakeConnection(std::move(func), group, executor);
+			ConnectInternal(result, true);
+			return ScopedConnection(std::move(result));
+		}
+		/*
+		like Connect, but the slot runs on the calling thread: emissions from other threads post it with copies of the arguments
+		to the Mailbox of this thread, which runs it in PumpEvents(). emissions from this thread call it right away
+		*/
+		auto ConnectAffine(SlotType func) -> ConnectionPtr
+		{
+			return ConnectAffine(std::move(func), 0);
+		}
+		auto ConnectAffine(SlotType func, int group) -> ConnectionPtr
+		{
+			static_assert(!std::is_same<Access, PlainAccess>::value, "ConnectAffine is for slots emitted from other threads, the reference counts of a SingleThreaded signal are not atomic");
+			auto mailbox = Mailbox::Current();
+			auto result = MakeConnection(std::move(func), group, mailbox.get());
+			result->mailbox_ = std::move(mailbox);
+			ConnectInternal(result);
+			return result;
+		}
+		// the slot gets each EmitBatch as one span of items, other emissions arrive as a batch of one
+		auto ConnectBatch(BatchSlot func, Executor* executor = nullptr) -> ConnectionPtr
+		{
+			auto result = Access::template AllocateShared<ConnectionType>(alloc_);
+			result->batch_slot_.reset(new BatchSlot(std::move(func)));
+			result->slot_ = BatchThunk{ result->batch_slot_.get() };
+			result->executor_ = executor;
+			ConnectInternal(result);
 			return result;
 		}
+#ifdef SIGSLOT_COROUTINES
+		/*
+		co_await it to suspend until the next emission, which resumes with a copy of its arguments: the argument itself for single
+		parameter signatures and a std::tuple of them otherwise, std::nullopt when the signal goes away first.
+		the awaiter lives in the coroutine frame and is linked into the signal, no connection is made and nothing is allocated.
+		executor : optional, where to resume; the signal's executor if not set, the emitting thread, after the slots, if neither is.
+		a coroutine destroyed while waiting unlinks itself, it must not be destroyed concurrently with the signal
+		*/
+		auto Next(Executor* executor = nullptr) -> NextEmission
+		{
+			return NextEmission(this, executor);
+		}
+		class NextEmission
+		{
+			friend class Signal;
+
+			Signal* signal_;
+			Executor* executor_;
+			std::coroutine_handle<> handle_;
+			std::optional<BatchItem> value_;
+			typename Access::template Atomic<Signal*> linked_{ nullptr };// the signal while we are in its list of waiters
+			NextEmission* prev_ = nullptr;// guarded by the lock_ of linked_
+			NextEmission* next_ = nullptr;
+
+			NextEmission(Signal* signal, Executor* executor) :
+				signal_(signal), executor_(executor)
+			{
+				static_assert(std::is_copy_constructible<BatchItem>::value, "Next() hands out copies of the arguments");
+			}
+			// must be called with the lock_ of linked_ held
+			void Unlink()
+			{
+				auto signal = linked_.load(std::memory_order_relaxed);
+				if (prev_)
+					prev_->next_ = next_;
+				else
+					signal->waiters_.store(next_, std::memory_order_relaxed);
+				if (next_)
+					next_->prev_ = prev_;
+				else
+					signal->last_waiter_ = prev_;
+				linked_.store(nullptr, std::memory_order_relaxed);
+			}
+			// resumes the waiters detached by TakeWaiters, each may destroy itself
+			static void ResumeAll(NextEmission* waiter, Executor* fallback)
+			{
+				while (nullptr != waiter)
+				{
+					auto next = waiter->next_;
+					auto executor = waiter->executor_ ? waiter->executor_ : fallback;
+					if (executor)
+						executor->Post(std::unique_ptr<Task>(new ResumeTask(waiter->handle_)));
+					else
+						waiter->handle_.resume();
+					waiter = next;
+				}
+			}
+		public:
+			NextEmission(const NextEmission&) = delete;
+			NextEmission& operator=(const NextEmission&) = delete;
+			~NextEmission()
+			{
+				auto signal = linked_.load(std::memory_order_acquire);
+				if (nullptr == signal)
+					return;
+				std::lock_guard<decltype(signal->lock_)> l(signal->lock_);
+				if (linked_.load(std::memory_order_relaxed))
+					Unlink();
+			}
+			bool await_ready() const { return false; }
+			void await_suspend(std::coroutine_handle<> handle)
+			{
+				handle_ = handle;
+				std::lock_guard<decltype(signal_->lock_)> l(signal_->lock_);
+				prev_ = signal_->last_waiter_;
+				next_ = nullptr;
+				if (prev_)
+					prev_->next_ = this;
+				else
+					signal_->waiters_.store(this, std::memory_order_release);
+				signal_->last_waiter_ = this;
+				linked_.store(signal_, std::memory_order_relaxed);
+			}
+			std::optional<BatchItem> await_resume() { return std::move(value_); }
+		};
+#endif
 		// this is not required, you can reset conn to disconnect
 //		void Disconnect(std::shared_ptr<Connection<Signature>> conn)
 //		{
@@ -125,41 +2434,583 @@ namespace nsSigslot
 //			conns_.clear();
 //		}
 	protected:
-		void ConnectInternal(void* p, std::shared_ptr<Connection<Signature>> conn)
+		typename Metrics::SignalCounters& Counters() { return *this; }
+		// a receiver deriving from Trackable keeps its member connections
+		template<typename Class>
+		static void Track(Class* object, const ConnectionPtr& conn, std::true_type)
 		{
-			std::lock_guard<decltype(lock_)> l(lock_);
-			conns_.push_back(std::make_pair(p,conn));
+			static_cast<BasicTrackableBase<Access>*>(object)->Track(conn);
+		}
+		template<typename Class>
+		static void Track(Class*, const ConnectionPtr&, std::false_type)
+		{
+			static_assert(!std::is_base_of<BasicTrackableBase<AtomicAccess>, Class>::value && !std::is_base_of<BasicTrackableBase<PlainAccess>, Class>::value,
+				"the Trackable of the receiver must be SingleThreaded when the signal is, and not otherwise");
+		}
+		auto MakeConnection(SlotType func, int group, Executor* executor) -> ConnectionPtr
+		{
+			// the connection and its control block share one allocation, disconnecting is done by ~BasicObjectBase
+			auto result = Access::template AllocateShared<ConnectionType>(alloc_);
+			result->slot_ = std::move(func);
+			result->executor_ = executor;
+			result->group_ = group;
+			return result;
+		}
+		// a slot invocation posted to an Executor, holds copies of the arguments
+		class QueuedCall :
+			public Task
+		{
+			typedef typename SignatureTraits<Signature>::Values Values;
+			WeakConnection conn_;
+			Values values_;
 
-			// replace the deleter
-			conn->deleter_ = [this](void* p)
+			template<size_t ...I>
+			void Call(ConnectionType& conn, IndexSequence<I...>)
+			{
+				// runs once, the values are ours to give away
+				conn(GiveArgument<typename std::tuple_element<I, typename SignatureTraits<Signature>::Arguments>::type>(std::get<I>(values_))...);
+			}
+		public:
+			template <typename ...Params>
+			QueuedCall(const ConnectionPtr& conn, Params&&... params) :
+				conn_(conn), values_(std::forward<Params>(params)...)
+			{}
+			void Run() override
+			{
+				auto conn = conn_.lock();
+				if (conn && !conn->closed_)
+					Call(*conn, typename MakeIndexSequence<std::tuple_size<Values>::value>::type());
+			}
+		};
+#ifdef SIGSLOT_COROUTINES
+		// detaches the list of waiters of Next() and gives each a copy of the arguments, resume them with NextEmission::ResumeAll
+		template <typename ...Params>
+		NextEmission* TakeWaiters(Params&... params)
+		{
+			if constexpr (!std::is_constructible<BatchItem, Params&...>::value)
+				return nullptr;// nobody can wait for move-only arguments
+			else
 			{
+				if (nullptr == waiters_.load(std::memory_order_acquire))
+					return nullptr;
 				std::lock_guard<decltype(lock_)> l(lock_);
-				auto conn_iter = std::find_if(conns_.begin(), conns_.end(), [p](WeakConnection iter) -> bool
+				auto result = DetachWaiters();
+				for (auto waiter = result; nullptr != waiter; waiter = waiter->next_)
+					waiter->value_.emplace(params...);
+				return result;
+			}
+		}
+		// must be called with lock_ held
+		NextEmission* DetachWaiters()
+		{
+			auto result = waiters_.load(std::memory_order_relaxed);
+			for (auto waiter = result; nullptr != waiter; waiter = waiter->next_)
+				waiter->linked_.store(nullptr, std::memory_order_relaxed);
+			waiters_.store(nullptr, std::memory_order_relaxed);
+			last_waiter_ = nullptr;
+			return result;
+		}
+#endif
+		// the slot_ of a batch connection
+		struct BatchThunk
+		{
+			BatchSlot* batch_slot_;
+			template <typename ...Params>
+			typename SignatureTraits<Signature>::Result operator()(Params&&... params) const
+			{
+				auto item = BatchItem(std::forward<Params>(params)...);
+				(*batch_slot_)(&item, 1);
+				return typename SignatureTraits<Signature>::Result();
+			}
+		};
+		static std::pair<const BatchItem*, size_t> Contiguous(const BatchItem* first, const BatchItem* last, std::vector<BatchItem>&)
+		{
+			return std::make_pair(first, static_cast<size_t>(last - first));
+		}
+		static std::pair<const BatchItem*, size_t> Contiguous(BatchItem* first, BatchItem* last, std::vector<BatchItem>&)
+		{
+			return std::make_pair(const_cast<const BatchItem*>(first), static_cast<size_t>(last - first));
+		}
+		template <typename Iterator>
+		static std::pair<const BatchItem*, size_t> Contiguous(Iterator first, Iterator last, std::vector<BatchItem>& copy)
+		{
+			if (copy.empty())
+				copy.assign(first, last);
+			return std::make_pair(const_cast<const BatchItem*>(copy.data()), copy.size());
+		}
+		template <typename Combiner, typename Item>
+		bool InvokeItem(const ConnectionPtr& conn, Combiner& combiner, const Item& item, std::true_type)
+		{
+			return Invoke(conn, combiner, item);
+		}
+		template <typename Combiner, typename ...T>
+		bool InvokeItem(const ConnectionPtr& conn, Combiner& combiner, const std::tuple<T...>& item, std::false_type)
+		{
+			return InvokeTuple(conn, combiner, item, typename MakeIndexSequence<sizeof...(T)>::type());
+		}
+		template <typename Combiner, typename Tuple, size_t ...I>
+		bool InvokeTuple(const ConnectionPtr& conn, Combiner& combiner, const Tuple& item, IndexSequence<I...>)
+		{
+			return Invoke(conn, combiner, std::get<I>(item)...);
+		}
+		template <typename Combiner, size_t ...I, typename ...Params>
+		bool InvokeShared(const ConnectionPtr& conn, Combiner& combiner, IndexSequence<I...>, Params&... params)
+		{
+			return Invoke(conn, combiner, ShareArgument<typename std::tuple_element<I, typename SignatureTraits<Signature>::Arguments>::type>(params)...);
+		}
+		// false when the combiner stops the emission
+		template <typename Combiner, typename ...Params>
+		bool Invoke(const ConnectionPtr& conn, Combiner& combiner, Params&&... params)
+		{
+			auto executor = conn->executor_ ? conn->executor_ : executor_.load(std::memory_order_relaxed);
+			if (nullptr == executor)
+				return conn->Call(combiner, std::forward<Params>(params)...);
+			if (conn->Enabled())
+				executor->Post(std::unique_ptr<Task>(new QueuedCall(conn, std::forward<Params>(params)...)));
+			return true;
+		}
+		// calls f(conn, last) for the live connections, until it returns false
+		template <typename F>
+		void ForEach(LockedDispatch, F&& f)
+		{
+			std::lock_guard<decltype(lock_)> l(lock_);
+			EmittingGuard guard(*this);
+
+			// index based, slots may connect while we are walking the array, they are called from the next emission on;
+			// expired connections stay in place as tombstones and are skipped
+			auto count = conns_.Size();
+			for (size_t i = 0; i < count; ++i)
+			{
+				ConnectionPtr locked;
+				auto conn = conns_[i].Lock(locked);
+				if (conn && !f(*conn, i + 1 == count))
+					break;
+			}
+		}
+		// keeps conns_ from being reordered by disconnects and grouped connects while LockedDispatch walks it
+		struct EmittingGuard
+		{
+			Signal& signal_;
+			EmittingGuard(Signal& signal) : signal_(signal) { ++signal_.emitting_; }
+			~EmittingGuard()
+			{
+				if (0 != --signal_.emitting_)
+					return;
+				signal_.Compact();
+				for (auto&& entry : signal_.pending_connect_)
+					signal_.Place(std::move(entry));
+				signal_.pending_connect_.clear();
+			}
+		};
+		template <typename F>
+		void ForEach(SnapshotDispatch, F&& f)
+		{
+			size_t count = 0;
+			{
+				// no lock and no reference count on the snapshot, it stays while we are in the section; the entries are
+				// locked one by one below, as with LockedDispatch
+				typename Access::Epoch::Guard guard;
+				auto snapshot = snapshot_.load(std::memory_order_seq_cst);
+				if (!snapshot)
+					return;
+
+				// expired connections are skipped, they leave the snapshot when the next compaction publishes a new one
+				count = snapshot->entries_.size();
+				for (size_t i = 0; i < count; ++i)
 				{
-					return iter.first == p;
-				});
-				if (conn_iter != conns_.end())
-					conns_.erase(conn_iter);
-			};
+					ConnectionPtr locked;
+					auto conn = snapshot->entries_[i].Lock(locked);
+					if (conn && !f(*conn, i + 1 == count))
+						break;
+				}
+			}
+
+			// no slot runs under lock_ here, so emitters can compact; one already being done or a Connect in progress is not waited for
+			if (Crowded(tombstones_.load(std::memory_order_relaxed), count))
+			{
+				std::unique_lock<decltype(lock_)> l(lock_, std::try_to_lock);
+				if (l.owns_lock())
+					Compact();
+			}
+		}
+		// must be called with lock_ held
+		void Publish(LockedDispatch)
+		{
+		}
+		void Publish(SnapshotDispatch)
+		{
+			SnapshotAllocator alloc(alloc_);
+			auto snapshot = std::allocator_traits<SnapshotAllocator>::allocate(alloc, 1);
+			new (snapshot) SnapshotEntries(conns_.begin(), conns_.end(), alloc_);
+			auto old = snapshot_.load(std::memory_order_relaxed);
+			snapshot_.store(snapshot, std::memory_order_seq_cst);
+			if (old)
+				retired_.push_back(Retired(Access::Epoch::Retire(), old));
+
+			// free the replaced snapshots no emitter can be reading any more, usually all of them
+			auto oldest = Access::Epoch::Oldest();
+			size_t kept = 0;
+			for (auto&& item : retired_)
+			{
+				if (item.first < oldest)
+					FreeSnapshot(item.second);
+				else
+					retired_[kept++] = item;
+			}
+			retired_.resize(kept);
+		}
+		void FreeSnapshot(SnapshotEntries* snapshot)
+		{
+			SnapshotAllocator alloc(alloc_);
+			snapshot->~SnapshotEntries();
+			std::allocator_traits<SnapshotAllocator>::deallocate(alloc, snapshot, 1);
+		}
+		// scoped : conns_ holds the only reference of conn besides its ScopedConnection
+		void ConnectInternal(ConnectionPtr conn, bool scoped = false)
+		{
+			std::lock_guard<decltype(lock_)> l(lock_);
+			Compact();
+			if (emitting_)
+				pending_connect_.push_back(Entry(conn, scoped));// without an owner until it is placed, so it can go away unnoticed
+			else
+				Place(Entry(conn, scoped));
+		}
+		// must be called with lock_ held
+		void Place(Entry entry)
+		{
+			ConnectionPtr locked;
+			auto conn = entry.Lock(locked);
+			if (!conn)
+				return;// went away before it was placed
+			auto raw = conn->get();
+			raw->key_ = conns_.Insert(std::move(entry), raw->group_);
+			raw->owner_ = this;
+			Publish(typename Policy::Dispatch());
+		}
+		static bool Crowded(int tombstones, size_t size)
+		{
+			return tombstones > 0 && static_cast<size_t>(tombstones) * Policy::CompactRatio >= size;
+		}
+		// erase the expired connections in one pass once there are enough of them, must be called with lock_ held
+		void Compact()
+		{
+			if (emitting_ || !Crowded(tombstones_.load(std::memory_order_relaxed), conns_.Size()))
+				return;
+
+			// a connection expires before its destructor counts it, so this may erase more than were counted
+			auto erased = conns_.EraseIf([](const Entry& entry) { return entry.Expired(); });
+			tombstones_.fetch_sub(static_cast<int>(erased), std::memory_order_relaxed);
+			Publish(typename Policy::Dispatch());
+		}
+		/*
+		called by the connection's destructor, from any thread and possibly in the middle of an emission.
+		only the count of tombstones is bumped, the entry itself stays in conns_ until it is compacted
+		*/
+		void Detach(BasicObjectBase<Access>*, SlotKey) override
+		{
+			tombstones_.fetch_add(1, std::memory_order_relaxed);
+		}
+	};
+	/*
+	a Signal for updates which come faster than they are worth delivering: emitting stores the arguments in place of the previous
+	ones and calls no slot, Flush() delivers the latest ones, if any came since the previous Flush, through the usual emission.
+	call Flush() from a timer or from the consumer's loop, e.g. before PumpEvents(); emitting through a Signal& is not coalesced
+	*/
+	template<typename Signature, typename Threading = std::recursive_mutex, typename Policy = DefaultPolicy>
+	class CoalescingSignal :
+		public Signal<Signature, Threading, Policy>
+	{
+		typedef Signal<Signature, Threading, Policy> Base;
+		typedef typename SignatureTraits<Signature>::Values Values;
+		typename Base::ThreadingModel::Lock value_lock_;
+		typename std::aligned_storage<sizeof(Values), alignof(Values)>::type latest_;// constructed by the first emission
+		bool stored_ = false;// guarded by value_lock_
+		bool pending_ = false;// emitted since the last Flush
+
+		Values* Latest() { return reinterpret_cast<Values*>(&latest_); }
+		template<typename Value>
+		void Store(Value&& value)
+		{
+			std::lock_guard<decltype(value_lock_)> l(value_lock_);
+			if (stored_)
+				*Latest() = std::forward<Value>(value);
+			else
+			{
+				new (&latest_) Values(std::forward<Value>(value));
+				stored_ = true;
+			}
+			pending_ = true;
+		}
+		void StoreItem(const typename Base::BatchItem& item, std::true_type) { Store(Values(item)); }
+		void StoreItem(const typename Base::BatchItem& item, std::false_type) { Store(item); }
+		template<size_t ...I>
+		void Deliver(Values& values, IndexSequence<I...>)
+		{
+			Base::operator()(GiveArgument<typename std::tuple_element<I, typename SignatureTraits<Signature>::Arguments>::type>(std::get<I>(values))...);
+		}
+	public:
+		CoalescingSignal() = default;
+		explicit CoalescingSignal(const typename Base::AllocatorType& alloc) : Base(alloc) {}
+		CoalescingSignal(const CoalescingSignal&) = delete;
+		CoalescingSignal& operator=(const CoalescingSignal&) = delete;
+		~CoalescingSignal()
+		{
+			if (stored_)
+				Latest()->~Values();
+		}
+		// keeps a copy of the arguments until the next Flush, an earlier one not flushed yet is dropped
+		template <typename ...Params>
+		void operator()(Params&&... params)
+		{
+			if (this->Enabled())
+				Store(Values(std::forward<Params>(params)...));
+		}
+		template <typename ...Params>
+		void Emit(Params&&... params)
+		{
+			operator()(std::forward<Params>(params)...);
+		}
+		// only the last element of [first, last) is kept
+		template <typename Iterator>
+		void EmitBatch(Iterator first, Iterator last)
+		{
+			if (first == last || !this->Enabled())
+				return;
+			auto item = first;
+			while (++first != last)
+				item = first;
+			StoreItem(*item, std::integral_constant<bool, 1 == SignatureTraits<Signature>::Arity>());
+		}
+		// emits the latest arguments if there were any since the previous Flush, returns whether it did
+		bool Flush()
+		{
+			std::unique_lock<decltype(value_lock_)> l(value_lock_);
+			if (!pending_)
+				return false;
+			pending_ = false;
+			Values values(std::move(*Latest()));
+			l.unlock();
+			Deliver(values, typename MakeIndexSequence<std::tuple_size<Values>::value>::type());
+			return true;
+		}
+		// whether an emission is waiting for Flush
+		bool Pending()
+		{
+			std::lock_guard<decltype(value_lock_)> l(value_lock_);
+			return pending_;
+		}
+	};
+	/*
+	a signal of at most N slots kept inline, for hot loops whose fan-out is known at compile time: no heap, no shared_ptr and no lock,
+	so it stays on one thread. slots are InlineFunction<Signature, InlineSize>; Connect returns a key for Disconnect and Enable, an invalid
+	one (see Connected) when the N slots are taken. as with Signal, slots connected while emitting are called from the next emission
+	on and a slot may disconnect itself. the order of the slots is unspecified, Policy::Combiner folds their results
+	*/
+	template<typename Signature, size_t N, size_t InlineSize = 32, typename Policy = DefaultPolicy>
+	class StaticSignal
+	{
+	public:
+		typedef InlineFunction<Signature, InlineSize> SlotType;
+		typedef typename Policy::template Combiner<typename SignatureTraits<Signature>::Result> CombinerType;
+		typedef typename CombinerType::ResultType ResultType;
+		typedef SlotKey Key;
+	private:
+		static_assert(N > 0 && N < 0xffffffff, "a StaticSignal holds 1 to 2^32 - 2 slots");
+		struct Slot
+		{
+			SlotType func_;
+			uint32_t generation_ = 0;// bumped on every Disconnect, so stale keys never match a reused slot
+			bool used_ = false;
+			bool enable_ = true;
+			bool armed_ = true;// false while connected during an emission
+			bool zombie_ = false;// disconnected during an emission, func_ is dropped once it is over
+		};
+		Slot slots_[N];
+		uint32_t count_ = 0;// slots_[count_, N) are free
+		uint32_t emitting_ = 0;// nesting depth of emissions
+		bool dirty_ = false;// slots were connected or disconnected while emitting
+		bool enable_ = true;
+
+		Slot* Find(Key key)
+		{
+			if (key.index >= N || !slots_[key.index].used_ || slots_[key.index].generation_ != key.generation)
+				return nullptr;
+			return &slots_[key.index];
+		}
+		void Shrink()
+		{
+			while (0 != count_ && !slots_[count_ - 1].used_ && !slots_[count_ - 1].zombie_)
+				--count_;
+		}
+		// arms the slots connected and drops the ones disconnected by the emission which just ended
+		struct EmittingGuard
+		{
+			StaticSignal& signal_;
+			EmittingGuard(StaticSignal& signal) : signal_(signal) { ++signal_.emitting_; }
+			~EmittingGuard()
+			{
+				if (0 != --signal_.emitting_ || !signal_.dirty_)
+					return;
+				for (uint32_t i = 0; i < signal_.count_; ++i)
+				{
+					auto&& slot = signal_.slots_[i];
+					slot.armed_ = true;
+					if (slot.zombie_)
+					{
+						slot.func_ = nullptr;
+						slot.zombie_ = false;
+					}
+				}
+				signal_.dirty_ = false;
+				signal_.Shrink();
+			}
+		};
+		template <typename ...Params>
+		static bool Call(const SlotType& func, CombinerType& combiner, std::false_type, Params&&... params)
+		{
+			return combiner(func(std::forward<Params>(params)...));
+		}
+		template <typename ...Params>
+		static bool Call(const SlotType& func, CombinerType&, std::true_type, Params&&... params)
+		{
+			func(std::forward<Params>(params)...);
+			return true;
+		}
+		template <size_t ...I, typename ...Params>
+		static bool CallShared(const SlotType& func, CombinerType& combiner, IndexSequence<I...>, Params&... params)
+		{
+			return Call(func, combiner, std::is_void<typename SignatureTraits<Signature>::Result>(),
+				ShareArgument<typename std::tuple_element<I, typename SignatureTraits<Signature>::Arguments>::type>(params)...);
+		}
+	public:
+		StaticSignal() = default;
+		StaticSignal(const StaticSignal&) = delete;
+		StaticSignal& operator=(const StaticSignal&) = delete;
+
+		template <typename ...Params>
+		auto operator()(Params&&... params) -> ResultType
+		{
+			CombinerType combiner;
+			if (!enable_)
+				return combiner.Result();
+
+			EmittingGuard guard(*this);
+			auto count = count_;
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				auto&& slot = slots_[i];
+				if (!slot.used_ || !slot.enable_ || !slot.armed_)
+					continue;
+				auto more = (i + 1 == count) ?
+					Call(slot.func_, combiner, std::is_void<typename SignatureTraits<Signature>::Result>(), std::forward<Params>(params)...) :
+					CallShared(slot.func_, combiner, typename MakeIndexSequence<sizeof...(Params)>::type(), params...);
+				if (!more)
+					break;
+			}
+			return combiner.Result();
+		}
+		template <typename ...Params>
+		auto Emit(Params&&... params) -> ResultType
+		{
+			return operator()(std::forward<Params>(params)...);
+		}
+		Key Connect(SlotType func)
+		{
+			for (uint32_t i = 0; i < N; ++i)
+			{
+				auto&& slot = slots_[i];
+				if (slot.used_ || slot.zombie_)
+					continue;
+				slot.func_ = std::move(func);
+				slot.used_ = true;
+				slot.enable_ = true;
+				slot.armed_ = 0 == emitting_;
+				if (emitting_)
+					dirty_ = true;
+				if (count_ <= i)
+					count_ = i + 1;
+				return Key{ i, slot.generation_ };
+			}
+			return Key{ 0xffffffff, 0 };
+		}
+		// false when key was already disconnected
+		bool Disconnect(Key key)
+		{
+			auto slot = Find(key);
+			if (nullptr == slot)
+				return false;
+			slot->used_ = false;
+			++slot->generation_;
+			if (emitting_)
+			{// it may be the slot running now
+				slot->zombie_ = true;
+				dirty_ = true;
+			}
+			else
+			{
+				slot->func_ = nullptr;
+				Shrink();
+			}
+			return true;
+		}
+		bool Connected(Key key) { return nullptr != Find(key); }
+		void Enable(Key key, bool enable = true)
+		{
+			auto slot = Find(key);
+			if (slot)
+				slot->enable_ = enable;
+		}
+		void Enable(bool enable = true) { enable_ = enable; }
+		bool Enabled() const { return enable_; }
+		// the number of connected slots
+		size_t Size() const
+		{
+			size_t result = 0;
+			for (uint32_t i = 0; i < count_; ++i)
+				result += slots_[i].used_ ? 1 : 0;
+			return result;
 		}
 	};
-	// a utility class to hold all connections/signals
-	template<typename Element, typename Mutex = std::recursive_mutex>
+
+	/*
+	a utility class to hold all connections/signals
+	Enable() switches all the objects saved to it, objects whose owner went away are dropped as it grows
+	*/
+	template<typename Element, typename Threading = std::recursive_mutex, typename Allocator = std::allocator<char>>
 	class ObjectContainer
 	{
-		Mutex lock_;
-		std::list<std::shared_ptr<Element>> items_;
+		typedef typename ThreadingOf<Threading>::type ThreadingModel;
+		typedef typename ThreadingModel::template SharedPtr<Element> ElementPtr;
+		typedef BasicEnableGate<typename ThreadingModel::Access> Gate;
+		typename ThreadingModel::Lock lock_;
+		std::vector<ElementPtr, typename std::allocator_traits<Allocator>::template rebind_alloc<ElementPtr>> items_;
+		size_t prune_at_ = 16;// items_ is swept for orphans when it reaches this size
+		Gate* gate_ = new Gate;
+
+		void Prune()
+		{
+			items_.erase(std::remove_if(items_.begin(), items_.end(), [](const ElementPtr& item) { return item->Orphaned(); }), items_.end());
+			prune_at_ = std::max<size_t>(16, items_.size() * 2);
+		}
 	public:
-		void Save(std::shared_ptr<Element> item)
+		ObjectContainer() = default;
+		explicit ObjectContainer(const Allocator& alloc) : items_(alloc) {}
+		ObjectContainer(const ObjectContainer&) = delete;
+		ObjectContainer& operator=(const ObjectContainer&) = delete;
+		~ObjectContainer(){ gate_->Release(); }
+		// an object saved to several containers follows the one switched last
+		void Save(ElementPtr item)
 		{
+			item->Join(gate_);
 			std::lock_guard<decltype(lock_)> l(lock_);
-			items_.push_back(item);
+			if (items_.size() >= prune_at_)
+				Prune();
+			items_.push_back(std::move(item));
 		}
+		// sets every saved object as a single store whatever their number; a later Enable() of an object, or EnableIf(), overrides it
 		void Enable(bool enable=true)
 		{
-			std::lock_guard<decltype(lock_)> l(lock_);
-			for (auto&& item : items_)
-				item->Enable(enable);
+			gate_->Enable(enable);
 		}
 		template<typename Comp>
 		void EnableIf(Comp comp, bool enable=true)